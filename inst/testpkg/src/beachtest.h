@@ -6,6 +6,7 @@
 #include "beachmat/integer_matrix.h"
 #include "beachmat/logical_matrix.h"
 #include "beachmat/character_matrix.h"
+#include "beachmat/parallel_apply.h"
 
 extern "C" { 
 
@@ -27,6 +28,52 @@ SEXP test_logical_slice (SEXP, SEXP, SEXP, SEXP);
 
 SEXP test_character_slice (SEXP, SEXP, SEXP, SEXP);
 
+// Block column access.
+
+SEXP test_numeric_cols (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_integer_cols (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_logical_cols (SEXP, SEXP, SEXP, SEXP);
+
+// Subset access.
+
+SEXP test_numeric_subset (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_integer_subset (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_logical_subset (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_character_subset (SEXP, SEXP, SEXP, SEXP);
+
+// Row cursor access.
+
+SEXP test_numeric_cursor (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_integer_cursor (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_logical_cursor (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_character_cursor (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_numeric_cursor_reuse (SEXP, SEXP);
+
+// Access with input parameters.
+
+SEXP test_numeric_param (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_integer_param (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_logical_param (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_character_param (SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_numeric_cols_param (SEXP, SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_integer_cols_param (SEXP, SEXP, SEXP, SEXP, SEXP);
+
+SEXP test_logical_cols_param (SEXP, SEXP, SEXP, SEXP, SEXP);
+
 // Const access.
 
 SEXP test_numeric_const_access (SEXP);
@@ -63,6 +110,8 @@ SEXP test_logical_nonzero_slice (SEXP, SEXP, SEXP,SEXP);
 
 SEXP test_sparse_numeric_slice(SEXP, SEXP);
 
+SEXP test_sparse_numeric_indexed_slice(SEXP, SEXP, SEXP);
+
 // Type checks.
 
 SEXP test_type_check(SEXP);
@@ -79,6 +128,16 @@ SEXP test_logical_to_integer (SEXP, SEXP);
 
 SEXP test_logical_to_numeric (SEXP, SEXP);
 
+// Parallel apply.
+
+SEXP test_numeric_parallel_apply (SEXP, SEXP, SEXP);
+
+SEXP test_character_parallel_apply (SEXP, SEXP, SEXP);
+
+// Single-precision access.
+
+SEXP test_numeric_float (SEXP, SEXP);
+
 // Edge cases.
 
 SEXP test_integer_edge (SEXP, SEXP);
@@ -107,10 +166,24 @@ SEXP test_character_output(SEXP, SEXP, SEXP);
 
 SEXP test_character_output_slice(SEXP, SEXP, SEXP, SEXP);
 
+SEXP test_numeric_parallel_output(SEXP, SEXP, SEXP);
+
+SEXP test_numeric_clone_output(SEXP);
+
+SEXP test_numeric_single_output(SEXP, SEXP, SEXP);
+
+SEXP test_integer_narrow_output(SEXP, SEXP, SEXP);
+
 SEXP test_sparse_numeric_output (SEXP, SEXP, SEXP);
 
 SEXP test_sparse_numeric_output_slice (SEXP, SEXP, SEXP, SEXP);
 
+SEXP test_sparse_numeric_spill_output (SEXP, SEXP, SEXP);
+
+SEXP test_sparse_numeric_spill_overlap (SEXP);
+
+SEXP test_sparse_numeric_parallel_output (SEXP, SEXP);
+
 SEXP test_sparse_logical_output (SEXP, SEXP, SEXP);
 
 SEXP test_sparse_logical_output_slice (SEXP, SEXP, SEXP, SEXP);
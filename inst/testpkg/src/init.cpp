@@ -18,6 +18,33 @@ static const R_CallMethodDef all_call_entries[] = {
     REGISTER(test_logical_slice, 4),
     REGISTER(test_character_slice, 4),
 
+    // Block column access.
+    REGISTER(test_numeric_cols, 4),
+    REGISTER(test_integer_cols, 4),
+    REGISTER(test_logical_cols, 4),
+
+    // Subset access.
+    REGISTER(test_numeric_subset, 4),
+    REGISTER(test_integer_subset, 4),
+    REGISTER(test_logical_subset, 4),
+    REGISTER(test_character_subset, 4),
+
+    // Row cursor access.
+    REGISTER(test_numeric_cursor, 4),
+    REGISTER(test_integer_cursor, 4),
+    REGISTER(test_logical_cursor, 4),
+    REGISTER(test_character_cursor, 4),
+    REGISTER(test_numeric_cursor_reuse, 2),
+
+    // Access with input parameters.
+    REGISTER(test_numeric_param, 4),
+    REGISTER(test_integer_param, 4),
+    REGISTER(test_logical_param, 4),
+    REGISTER(test_character_param, 4),
+    REGISTER(test_numeric_cols_param, 5),
+    REGISTER(test_integer_cols_param, 5),
+    REGISTER(test_logical_cols_param, 5),
+
     // Const access.
     REGISTER(test_numeric_const_access, 1),
     REGISTER(test_integer_const_access, 1),
@@ -40,6 +67,7 @@ static const R_CallMethodDef all_call_entries[] = {
 
     // Sparse access.
     REGISTER(test_sparse_numeric_slice, 2),
+    REGISTER(test_sparse_numeric_indexed_slice, 3),
 
     // Type checks.
     REGISTER(test_type_check, 1),
@@ -50,6 +78,13 @@ static const R_CallMethodDef all_call_entries[] = {
     REGISTER(test_logical_to_integer, 2),
     REGISTER(test_logical_to_numeric, 2),
 
+    // Parallel apply.
+    REGISTER(test_numeric_parallel_apply, 3),
+    REGISTER(test_character_parallel_apply, 3),
+
+    // Single-precision access.
+    REGISTER(test_numeric_float, 2),
+
     // Edge cases.
     REGISTER(test_integer_edge, 2),
     REGISTER(test_numeric_edge, 2),
@@ -67,8 +102,16 @@ static const R_CallMethodDef all_call_entries[] = {
     REGISTER(test_logical_output_slice, 4),
     REGISTER(test_character_output_slice, 4),
 
+    REGISTER(test_numeric_parallel_output, 3),
+    REGISTER(test_numeric_clone_output, 1),
+    REGISTER(test_numeric_single_output, 3),
+    REGISTER(test_integer_narrow_output, 3),
+
     REGISTER(test_sparse_numeric_output, 3),
     REGISTER(test_sparse_numeric_output_slice, 4),
+    REGISTER(test_sparse_numeric_spill_output, 3),
+    REGISTER(test_sparse_numeric_spill_overlap, 1),
+    REGISTER(test_sparse_numeric_parallel_output, 2),
     REGISTER(test_sparse_logical_output, 3),
     REGISTER(test_sparse_logical_output_slice, 4),
 
@@ -125,6 +125,125 @@ O fill_up_slice (M ptr, const Rcpp::IntegerVector& mode, const Rcpp::IntegerVect
     return output;
 }
 
+/* This function tests the get_cols methods for block extraction of columns.
+ * The second mode splits the block into two calls to check the offsets.
+ */
+
+template <class T, class O, class M>  
+O fill_up_cols (M ptr, const Rcpp::IntegerVector& mode, const Rcpp::IntegerVector& rows, const Rcpp::IntegerVector& cols) {
+    if (mode.size()!=1) { 
+        throw std::runtime_error("'mode' should be an integer scalar"); 
+    }
+    const int Mode=mode[0];
+
+    if (rows.size()!=2) { 
+        throw std::runtime_error("'rows' should be an integer vector of length 2"); 
+    }
+    const int rstart=rows[0]-1, rend=rows[1];
+    const int nrows=rend-rstart;    
+
+    if (cols.size()!=2) { 
+        throw std::runtime_error("'cols' should be an integer vector of length 2"); 
+    }
+    const int cstart=cols[0]-1, cend=cols[1];
+    const int ncols=cend-cstart;    
+
+    O output(nrows, ncols);
+    T target(nrows*ncols);
+    if (Mode==1) { 
+        // All at once.
+        ptr->get_cols(cstart, cend, target.begin(), rstart, rend);
+    } else if (Mode==2) {
+        // Split into two blocks.
+        const int cmid=cstart + ncols/2;
+        ptr->get_cols(cstart, cmid, target.begin(), rstart, rend);
+        ptr->get_cols(cmid, cend, target.begin() + (cmid - cstart)*nrows, rstart, rend);
+    } else { 
+        throw std::runtime_error("'mode' should be in [1,2]"); 
+    }
+
+    std::copy(target.begin(), target.end(), output.begin());
+    return output;
+}
+
+/* This function tests the use of row cursors, by splitting the column slice into two halves
+ * and alternating between them for each row. The second mode traverses the rows in reverse.
+ */
+
+template <class T, class O, class M>  
+O fill_up_cursor (M ptr, const Rcpp::IntegerVector& mode, const Rcpp::IntegerVector& rows, const Rcpp::IntegerVector& cols) {
+    if (mode.size()!=1) { 
+        throw std::runtime_error("'mode' should be an integer scalar"); 
+    }
+    const int Mode=mode[0];
+    if (Mode!=1 && Mode!=2) {
+        throw std::runtime_error("'mode' should be in [1,2]"); 
+    }
+
+    if (rows.size()!=2) { 
+        throw std::runtime_error("'rows' should be an integer vector of length 2"); 
+    }
+    const int rstart=rows[0]-1, rend=rows[1];
+    const int nrows=rend-rstart;    
+
+    if (cols.size()!=2) { 
+        throw std::runtime_error("'cols' should be an integer vector of length 2"); 
+    }
+    const int cstart=cols[0]-1, cend=cols[1];
+    const int ncols=cend-cstart;    
+    const int cmid=cstart + ncols/2;
+
+    O output(nrows, ncols);
+    T target(ncols);
+    beachmat::row_cursor left, right;
+    for (int i=0; i<nrows; ++i) {
+        const int r=(Mode==1 ? i : nrows - i - 1);
+        ptr->get_row(r+rstart, target.begin(), cstart, cmid, left);
+        ptr->get_row(r+rstart, target.begin() + (cmid - cstart), cmid, cend, right);
+        for (int c=0; c<ncols; ++c) {
+            output[c * nrows + r]=target[c];
+        }
+    }
+
+    return output;
+}
+
+/* This function tests the get_row_subset/get_col_subset methods with sorted indices. */
+
+template <class T, class O, class M>  
+O fill_up_subset (M ptr, const Rcpp::IntegerVector& mode, const Rcpp::IntegerVector& rows, const Rcpp::IntegerVector& cols) {
+    if (mode.size()!=1) { 
+        throw std::runtime_error("'mode' should be an integer scalar"); 
+    }
+    const int Mode=mode[0];
+    const size_t nrows=rows.size(), ncols=cols.size();
+    O output(nrows, ncols);
+
+    if (Mode==1) { 
+        // By column.
+        T target(nrows);
+        for (size_t c=0; c<ncols; ++c) {
+            ptr->get_col_subset(cols[c], rows.begin(), nrows, target.begin());
+            for (size_t r=0; r<nrows; ++r) {
+                output[c * nrows + r]=target[r];
+            }
+        }
+    } else if (Mode==2) { 
+        // By row.
+        T target(ncols);
+        for (size_t r=0; r<nrows; ++r) {
+            ptr->get_row_subset(rows[r], cols.begin(), ncols, target.begin());
+            for (size_t c=0; c<ncols; ++c) {
+                output[c * nrows + r]=target[c];
+            }
+        }
+    } else { 
+        throw std::runtime_error("'mode' should be in [1,2]"); 
+    }
+
+    return output;
+}
+
 /* This function tests the get_const_col methods, with or without the use of slices.  */
 
 template <class T, class O, class M>  
@@ -200,6 +319,16 @@ O fill_up_nonzero (M ptr, const Rcpp::IntegerVector& mode) {
                 output[nrows * (*iIt) + r]=*tIt;
             }
         }
+    } else if (Mode==3) {
+        // By column, without copying.
+        for (int c=0; c<ncols; ++c) {
+            auto view=ptr->get_const_nonzero_col(c);
+            auto iIt=view.index;
+            auto tIt=view.value;
+            for (size_t x=0; x<view.n; ++x, ++iIt, ++tIt) {
+                output[c * nrows + *iIt]=*tIt;
+            }
+        }
     } 
     return output;
 }
@@ -250,8 +379,18 @@ O fill_up_nonzero_slice (M ptr, const Rcpp::IntegerVector& mode, const Rcpp::Int
                 output[nrows * (*iIt - cstart) + r]=*tIt;
             }
         }
+    } else if (Mode==3) {
+        // By column, without copying.
+        for (int c=0; c<ncols; ++c) {
+            auto view=ptr->get_const_nonzero_col(c+cstart, rstart, rend);
+            auto iIt=view.index;
+            auto tIt=view.value;
+            for (size_t x=0; x<view.n; ++x, ++iIt, ++tIt) {
+                output[c * nrows + (*iIt - rstart)]=*tIt;
+            }
+        }
     } else { 
-        throw std::runtime_error("'mode' should be in [1,2]"); 
+        throw std::runtime_error("'mode' should be in [1,3]"); 
     }
     return output;
 }
@@ -61,6 +61,195 @@ SEXP test_character_slice (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
     END_RCPP
 }
 
+/* Realized block column access functions. */
+
+SEXP test_numeric_cols (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    return fill_up_cols<Rcpp::NumericVector, Rcpp::NumericMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_integer_cols (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_integer_matrix(in);
+    return fill_up_cols<Rcpp::IntegerVector, Rcpp::IntegerMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_logical_cols (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_logical_matrix(in);
+    return fill_up_cols<Rcpp::LogicalVector, Rcpp::LogicalMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+/* Realized subset access functions. */
+
+SEXP test_numeric_subset (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    return fill_up_subset<Rcpp::NumericVector, Rcpp::NumericMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_integer_subset (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_integer_matrix(in);
+    return fill_up_subset<Rcpp::IntegerVector, Rcpp::IntegerMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_logical_subset (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_logical_matrix(in);
+    return fill_up_subset<Rcpp::LogicalVector, Rcpp::LogicalMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_character_subset (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_character_matrix(in);
+    return fill_up_subset<Rcpp::StringVector, Rcpp::StringMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+/* Row cursor access functions. */
+
+SEXP test_numeric_cursor (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    return fill_up_cursor<Rcpp::NumericVector, Rcpp::NumericMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_integer_cursor (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_integer_matrix(in);
+    return fill_up_cursor<Rcpp::IntegerVector, Rcpp::IntegerMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_logical_cursor (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_logical_matrix(in);
+    return fill_up_cursor<Rcpp::LogicalVector, Rcpp::LogicalMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_character_cursor (SEXP in, SEXP mode, SEXP rx, SEXP cx) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_character_matrix(in);
+    return fill_up_cursor<Rcpp::StringVector, Rcpp::StringMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+/* Reusing a cursor on a second matrix, after scanning all rows of the first matrix. 
+ * The second matrix is then read from the same last row, in reverse.
+ */
+
+SEXP test_numeric_cursor_reuse (SEXP in, SEXP in2) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    auto ptr2=beachmat::create_numeric_matrix(in2);
+    const size_t nrows=ptr->get_nrow(), ncols=ptr->get_ncol();
+    if (nrows!=ptr2->get_nrow() || ncols!=ptr2->get_ncol()) {
+        throw std::runtime_error("matrices should have the same dimensions");
+    }
+
+    beachmat::row_cursor cursor;
+    Rcpp::NumericVector target(ncols);
+    for (size_t r=0; r<nrows; ++r) {
+        ptr->get_row(r, target.begin(), 0, ncols, cursor);
+    }
+
+    Rcpp::NumericMatrix output(nrows, ncols);
+    for (size_t r=nrows; r>0; --r) {
+        ptr2->get_row(r-1, target.begin(), 0, ncols, cursor);
+        for (size_t c=0; c<ncols; ++c) {
+            output[c * nrows + r - 1]=target[c];
+        }
+    }
+    return output;
+    END_RCPP
+}
+
+/* Access functions with input parameters. */
+
+beachmat::input_param choose_input_param(SEXP option) {
+    const std::string choice=Rcpp::as<std::string>(option);
+    beachmat::input_param param;
+    if (choice=="prefetch") {
+        param.set_prefetch(true);
+    } else if (choice=="shared") {
+        param.set_shared_cache(true);
+    } else if (choice=="both") {
+        param.set_prefetch(true);
+        param.set_shared_cache(true);
+    } else if (choice=="parallel") {
+        param.set_threads(3);
+    } else {
+        throw std::runtime_error("unknown input parameter option");
+    }
+    return param;
+}
+
+SEXP test_numeric_param (SEXP in, SEXP mode, SEXP order, SEXP option) {
+    BEGIN_RCPP
+    auto param=choose_input_param(option);
+    auto ptr=beachmat::create_numeric_matrix(in, param);
+    return fill_up<Rcpp::NumericVector, Rcpp::NumericMatrix>(ptr.get(), mode, order);
+    END_RCPP
+}
+
+SEXP test_integer_param (SEXP in, SEXP mode, SEXP order, SEXP option) {
+    BEGIN_RCPP
+    auto param=choose_input_param(option);
+    auto ptr=beachmat::create_integer_matrix(in, param);
+    return fill_up<Rcpp::IntegerVector, Rcpp::IntegerMatrix>(ptr.get(), mode, order);
+    END_RCPP
+}
+
+SEXP test_logical_param (SEXP in, SEXP mode, SEXP order, SEXP option) {
+    BEGIN_RCPP
+    auto param=choose_input_param(option);
+    auto ptr=beachmat::create_logical_matrix(in, param);
+    return fill_up<Rcpp::LogicalVector, Rcpp::LogicalMatrix>(ptr.get(), mode, order);
+    END_RCPP
+}
+
+SEXP test_character_param (SEXP in, SEXP mode, SEXP order, SEXP option) {
+    BEGIN_RCPP
+    auto param=choose_input_param(option);
+    auto ptr=beachmat::create_character_matrix(in, param);
+    return fill_up<Rcpp::StringVector, Rcpp::StringMatrix>(ptr.get(), mode, order);
+    END_RCPP
+}
+
+SEXP test_numeric_cols_param (SEXP in, SEXP mode, SEXP rx, SEXP cx, SEXP option) {
+    BEGIN_RCPP
+    auto param=choose_input_param(option);
+    auto ptr=beachmat::create_numeric_matrix(in, param);
+    return fill_up_cols<Rcpp::NumericVector, Rcpp::NumericMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_integer_cols_param (SEXP in, SEXP mode, SEXP rx, SEXP cx, SEXP option) {
+    BEGIN_RCPP
+    auto param=choose_input_param(option);
+    auto ptr=beachmat::create_integer_matrix(in, param);
+    return fill_up_cols<Rcpp::IntegerVector, Rcpp::IntegerMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
+SEXP test_logical_cols_param (SEXP in, SEXP mode, SEXP rx, SEXP cx, SEXP option) {
+    BEGIN_RCPP
+    auto param=choose_input_param(option);
+    auto ptr=beachmat::create_logical_matrix(in, param);
+    return fill_up_cols<Rcpp::LogicalVector, Rcpp::LogicalMatrix>(ptr.get(), mode, rx, cx);
+    END_RCPP
+}
+
 /* Const access functions. */
 
 SEXP test_numeric_const_access (SEXP in) {
@@ -192,6 +381,30 @@ SEXP test_sparse_numeric_slice(SEXP in, SEXP Inx) {
     END_RCPP
 }
 
+SEXP test_sparse_numeric_indexed_slice(SEXP in, SEXP Inx, SEXP limit) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    ptr->enable_row_index(Rcpp::as<double>(limit));
+    const int& nrows=ptr->get_nrow();
+    
+    Rcpp::IntegerMatrix inx(Inx);
+    if (inx.nrow()!=nrows) {
+        throw std::runtime_error("'Inx' and input matrix should have same number of rows");
+    }
+    Rcpp::List output(nrows);
+        
+    // By row in reverse order, using the requested column indices (checking random access with the row index).
+    for (int r=nrows-1; r>=0; --r) {
+        int start=inx(r, 0)-1, end=inx(r, 1);
+        Rcpp::NumericVector target(end-start);
+        ptr->get_row(r, target.begin(), start, end);
+        output[r]=target;
+    }
+
+    return output;
+    END_RCPP
+}
+
 /* Type check and conversion functions. */
 
 SEXP test_type_check(SEXP in) {
@@ -243,6 +456,109 @@ SEXP test_integer_to_logical (SEXP in, SEXP mode) {
     END_RCPP
 }
 
+/* Parallel apply functions, where mode 1 and 2 fill the output by column and by row, respectively. */
+
+SEXP test_numeric_parallel_apply (SEXP in, SEXP mode, SEXP threads) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    const size_t nrows=ptr->get_nrow(), ncols=ptr->get_ncol();
+    Rcpp::NumericMatrix output(nrows, ncols);
+    const int nthreads=Rcpp::IntegerVector(threads)[0];
+
+    if (Rcpp::IntegerVector(mode)[0]==1) {
+        beachmat::parallel_apply_cols(*ptr, [&](beachmat::numeric_matrix& mat, size_t c, size_t) -> void {
+            mat.get_col(c, output.begin() + c*nrows);
+        }, nthreads);
+    } else {
+        std::vector<std::vector<double> > workspace(nthreads, std::vector<double>(ncols));
+        beachmat::parallel_apply_rows(*ptr, [&](beachmat::numeric_matrix& mat, size_t r, size_t t) -> void {
+            auto& current=workspace[t];
+            mat.get_row(r, current.data());
+            for (size_t c=0; c<ncols; ++c) {
+                output[c*nrows + r]=current[c];
+            }
+        }, nthreads);
+    }
+    return output;
+    END_RCPP
+}
+
+SEXP test_character_parallel_apply (SEXP in, SEXP mode, SEXP threads) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_character_matrix(in);
+    const size_t nrows=ptr->get_nrow(), ncols=ptr->get_ncol();
+    Rcpp::StringMatrix output(nrows, ncols);
+    const int nthreads=Rcpp::IntegerVector(threads)[0];
+
+    if (Rcpp::IntegerVector(mode)[0]==1) {
+        beachmat::parallel_apply_cols(*ptr, [&](beachmat::character_matrix& mat, size_t c, size_t) -> void {
+            mat.get_col(c, output.begin() + c*nrows);
+        }, nthreads);
+    } else {
+        Rcpp::StringVector workspace(ncols);
+        beachmat::parallel_apply_rows(*ptr, [&](beachmat::character_matrix& mat, size_t r, size_t) -> void {
+            mat.get_row(r, workspace.begin());
+            for (size_t c=0; c<ncols; ++c) {
+                output[c*nrows + r]=workspace[c];
+            }
+        }, nthreads);
+    }
+    return output;
+    END_RCPP
+}
+
+/* Single-precision access, where mode 1 and 2 pass each column and row (respectively) through a float* 
+ * workspace into an output matrix, and mode 3 extracts the non-zero values of each column as floats.
+ */
+
+SEXP test_numeric_float (SEXP in, SEXP mode) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    const size_t nrows=ptr->get_nrow(), ncols=ptr->get_ncol();
+    Rcpp::NumericMatrix output(nrows, ncols);
+    const int Mode=Rcpp::IntegerVector(mode)[0];
+
+    if (Mode==1) {
+        auto optr=beachmat::create_numeric_output(nrows, ncols, beachmat::output_param(in));
+        std::vector<float> workspace(nrows);
+        for (size_t c=0; c<ncols; ++c) {
+            ptr->get_col(c, workspace.data());
+            optr->set_col(c, workspace.data());
+        }
+        for (size_t c=0; c<ncols; ++c) {
+            optr->get_col(c, workspace.data());
+            std::copy(workspace.begin(), workspace.end(), output.begin() + c*nrows);
+        }
+    } else if (Mode==2) {
+        auto optr=beachmat::create_numeric_output(nrows, ncols, beachmat::output_param(in));
+        std::vector<float> workspace(ncols);
+        for (size_t r=0; r<nrows; ++r) {
+            ptr->get_row(r, workspace.data());
+            optr->set_row(r, workspace.data());
+        }
+        for (size_t r=0; r<nrows; ++r) {
+            optr->get_row(r, workspace.data());
+            for (size_t c=0; c<ncols; ++c) {
+                output[c*nrows + r]=workspace[c];
+            }
+        }
+    } else if (Mode==3) {
+        std::vector<int> index(nrows);
+        std::vector<float> workspace(nrows);
+        for (size_t c=0; c<ncols; ++c) {
+            const size_t n=ptr->get_nonzero_col(c, index.data(), workspace.data());
+            auto curcol=output.begin() + c*nrows;
+            for (size_t i=0; i<n; ++i) {
+                curcol[index[i]]=workspace[i];
+            }
+        }
+    } else {
+        throw std::runtime_error("unknown mode for single-precision access");
+    }
+    return output;
+    END_RCPP
+}
+
 /* Edge case error checking. */
 
 SEXP test_integer_edge (SEXP in, SEXP mode) {
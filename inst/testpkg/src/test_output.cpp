@@ -41,6 +41,78 @@ SEXP test_character_output(SEXP in, SEXP mode, SEXP order) {
     END_RCPP
 }
 
+/* Realized output with parallel compression. */
+
+SEXP test_numeric_parallel_output(SEXP in, SEXP mode, SEXP order) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    beachmat::output_param op(in);
+    op.set_threads(3);
+    auto optr=beachmat::create_numeric_output(ptr->get_nrow(), ptr->get_ncol(), op);
+    auto optr2=beachmat::create_numeric_output(ptr->get_nrow(), ptr->get_ncol(), beachmat::SIMPLE_PARAM);
+    return pump_out<Rcpp::NumericVector>(ptr.get(), optr.get(), optr2.get(), mode, order);
+    END_RCPP
+}
+
+/* Realized output written through a clone, where the original and the clone fill alternate columns. */
+
+SEXP test_numeric_clone_output(SEXP in) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    const size_t nrows=ptr->get_nrow(), ncols=ptr->get_ncol();
+    auto optr=beachmat::create_numeric_output(nrows, ncols, beachmat::output_param(in));
+    auto optr2=optr->clone();
+
+    Rcpp::NumericVector target(nrows), target2(nrows);
+    for (size_t c=0; c<ncols; ++c) {
+        ptr->get_col(c, target.begin());
+        (c%2 ? optr2 : optr)->set_col(c, target.begin());
+    }
+
+    // Both instances should see all values, including those written by the other.
+    for (size_t c=0; c<ncols; ++c) {
+        ptr->get_col(c, target.begin());
+        optr->get_col(c, target2.begin());
+        if (!std::equal(target.begin(), target.end(), target2.begin())) {
+            throw std::runtime_error("values written by the clone are not visible in the original");
+        }
+        optr2->get_col(c, target2.begin());
+        if (!std::equal(target.begin(), target.end(), target2.begin())) {
+            throw std::runtime_error("values written by the original are not visible in the clone");
+        }
+    }
+
+    optr2.reset();
+    return optr->yield();
+    END_RCPP
+}
+
+/* Realized output with single-precision storage. */
+
+SEXP test_numeric_single_output(SEXP in, SEXP mode, SEXP order) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in);
+    beachmat::output_param op(in);
+    op.set_single_precision(true);
+    auto optr=beachmat::create_numeric_output(ptr->get_nrow(), ptr->get_ncol(), op);
+    auto optr2=beachmat::create_numeric_output(ptr->get_nrow(), ptr->get_ncol(), beachmat::SIMPLE_PARAM);
+    return pump_out<Rcpp::NumericVector>(ptr.get(), optr.get(), optr2.get(), mode, order);
+    END_RCPP
+}
+
+/* Realized output with narrow integer storage. */
+
+SEXP test_integer_narrow_output(SEXP in, SEXP mode, SEXP order) {
+    BEGIN_RCPP
+    auto ptr=beachmat::create_integer_matrix(in);
+    beachmat::output_param op(in);
+    op.set_integer_range(0, 1000); // stored as 16-bit unsigned integers.
+    auto optr=beachmat::create_integer_output(ptr->get_nrow(), ptr->get_ncol(), op);
+    auto optr2=beachmat::create_integer_output(ptr->get_nrow(), ptr->get_ncol(), beachmat::SIMPLE_PARAM);
+    return pump_out<Rcpp::IntegerVector>(ptr.get(), optr.get(), optr2.get(), mode, order);
+    END_RCPP
+}
+
 /* Realized output slice functions. */
 
 SEXP test_integer_output_slice(SEXP in, SEXP mode, SEXP rx, SEXP cx) {
@@ -197,6 +269,106 @@ SEXP test_sparse_numeric_output_slice(SEXP in, SEXP mode, SEXP rx, SEXP cx) {
     END_RCPP
 }
 
+/* Sparse output with a tiny memory limit, so that all but the smallest columns are spilled to file after nearly every write. */
+
+SEXP test_sparse_numeric_spill_output(SEXP in, SEXP mode, SEXP order) { 
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in); // should be a sparse matrix.
+    beachmat::output_param op(in, false, true);
+    op.set_memory_limit(16);
+    auto optr=beachmat::create_numeric_output(ptr->get_nrow(), ptr->get_ncol(), op);
+    auto optr2=beachmat::create_numeric_output(ptr->get_nrow(), ptr->get_ncol(), beachmat::SIMPLE_PARAM);
+    return pump_out<Rcpp::NumericVector>(ptr.get(), optr.get(), optr2.get(), mode, order);
+    END_RCPP
+}
+
+SEXP test_sparse_numeric_spill_overlap(SEXP in) { 
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in); // should be a sparse matrix.
+    const size_t nrows=ptr->get_nrow(), ncols=ptr->get_ncol();
+    beachmat::output_param op(in, false, true);
+    op.set_memory_limit(16);
+    auto optr=beachmat::create_numeric_output(nrows, ncols, op);
+    auto optr2=beachmat::create_numeric_output(nrows, ncols, beachmat::SIMPLE_PARAM);
+
+    // Filling all columns, and then overwriting overlapping ranges of each column with values from other columns.
+    // This forces spilled columns to be reloaded and spliced.
+    Rcpp::NumericVector target(nrows);
+    for (size_t c=0; c<ncols; ++c) {
+        ptr->get_col(c, target.begin());
+        optr->set_col(c, target.begin());
+        optr2->set_col(c, target.begin());
+    }
+
+    const size_t first=nrows/3, last=(2*nrows)/3;
+    for (size_t c=0; c<ncols; ++c) {
+        ptr->get_col((c+1)%ncols, target.begin());
+        optr->set_col(c, target.begin(), 0, last);
+        optr2->set_col(c, target.begin(), 0, last);
+    }
+    for (size_t c=ncols; c>0; --c) {
+        ptr->get_col((c+1)%ncols, target.begin());
+        optr->set_col(c-1, target.begin() + first, first, nrows);
+        optr2->set_col(c-1, target.begin() + first, first, nrows);
+    }
+
+    // Checking that all getters agree with the simple output.
+    Rcpp::NumericVector target2(nrows);
+    for (size_t c=0; c<ncols; ++c) {
+        optr->get_col(c, target.begin());
+        optr2->get_col(c, target2.begin());
+        if (!std::equal(target.begin(), target.end(), target2.begin())) {
+            throw std::runtime_error("spilled columns are not correctly extracted");
+        }
+        optr->get_col(c, target.begin(), first, last);
+        if (!std::equal(target.begin(), target.begin() + last - first, target2.begin() + first)) {
+            throw std::runtime_error("spilled column slices are not correctly extracted");
+        }
+    }
+
+    Rcpp::NumericVector rtarget(ncols), rtarget2(ncols);
+    for (size_t r=0; r<nrows; ++r) {
+        optr->get_row(r, rtarget.begin());
+        optr2->get_row(r, rtarget2.begin());
+        if (!std::equal(rtarget.begin(), rtarget.end(), rtarget2.begin())) {
+            throw std::runtime_error("spilled rows are not correctly extracted");
+        }
+    }
+
+    return Rcpp::List::create(optr->yield(), optr2->yield());
+    END_RCPP
+}
+
+/* Sparse output yielded in parallel, then read back, modified and yielded again. */
+
+SEXP test_sparse_numeric_parallel_output(SEXP in, SEXP limit) { 
+    BEGIN_RCPP
+    auto ptr=beachmat::create_numeric_matrix(in); // should be a sparse matrix.
+    const size_t nrows=ptr->get_nrow(), ncols=ptr->get_ncol();
+    beachmat::output_param op(in, false, true);
+    op.set_threads(3);
+    op.set_memory_limit(Rf_asInteger(limit));
+    auto optr=beachmat::create_numeric_output(nrows, ncols, op);
+    auto optr2=beachmat::create_numeric_output(nrows, ncols, beachmat::SIMPLE_PARAM);
+
+    Rcpp::NumericVector target(nrows);
+    for (size_t c=0; c<ncols; ++c) {
+        ptr->get_col(c, target.begin());
+        optr->set_col(c, target.begin());
+    }
+    Rcpp::RObject first=optr->yield();
+
+    // Reading back after the yield, and refilling each column in reverse.
+    for (size_t c=0; c<ncols; ++c) {
+        optr->get_col(c, target.begin());
+        std::reverse(target.begin(), target.end());
+        optr->set_col(c, target.begin());
+        optr2->set_col(c, target.begin());
+    }
+    return Rcpp::List::create(first, optr->yield(), optr2->yield());
+    END_RCPP
+}
+
 SEXP test_sparse_logical_output(SEXP in, SEXP mode, SEXP order) { 
     BEGIN_RCPP
     auto ptr=beachmat::create_logical_matrix(in); // should be a sparse matrix.
@@ -20,15 +20,34 @@ public:
     template <class Iter>
     void get_row(size_t, Iter, size_t, size_t);
 
+    template <class Iter>
+    void get_row(size_t, Iter, size_t, size_t, row_cursor&);
+
     template <class Iter>
     void get_col(size_t, Iter, size_t, size_t);
 
+    template <class Iter>
+    void get_cols(size_t, size_t, Iter, size_t, size_t);
+
+    template <class Iter>
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
+    template <class Iter>
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
     template<class Iter>
     size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Iter, size_t, size_t);
 
+    template<class Iter>
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Iter, size_t, size_t, row_cursor&);
+
     template<class Iter>
     size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, Iter, size_t, size_t);
 
+    size_t get_const_nonzero_col(size_t, Rcpp::IntegerVector::const_iterator&, typename V::const_iterator&, size_t, size_t);
+
+    void enable_row_index(size_t);
+
     Rcpp::RObject yield () const;
     matrix_type get_matrix_type () const;
 protected:
@@ -36,9 +55,30 @@ protected:
     Rcpp::IntegerVector i, p;
     V x;
 
-    size_t currow, curstart, curend;
-    std::vector<int> indices; // Left as 'int' to simplify comparisons with 'i' and 'p'.
-    void update_indices(size_t, size_t, size_t);
+    /* Raw pointers to the slot contents, which are used by all getters. This ensures that
+     * extraction never goes through the R API, e.g., for bounds checks or length queries, 
+     * such that clones can be used in worker threads. The slots are kept to protect the data.
+     */
+    const int* iptr;
+    const int* pptr;
+    const T* xptr;
+    size_t nnz;
+
+    /* Transposed (CSR) index for random row access, built when requested by enable_row_index().
+     * This contains row pointers, column indices and offsets into 'x' for each non-zero element.
+     * The index is immutable once built and is shared by all clones, rather than being copied.
+     */
+    struct row_index {
+        std::vector<int> p, c, x;
+    };
+    std::shared_ptr<const row_index> rindex;
+    bool row_index_requested;
+    size_t row_index_limit;
+    bool prepare_row_index();
+    void find_row_range(size_t, size_t, size_t, std::vector<int>::const_iterator&, std::vector<int>::const_iterator&) const;
+
+    row_cursor cursor; // Used when no cursor is supplied by the caller.
+    void update_indices(size_t, size_t, size_t, row_cursor&);
 
     T get_empty() const; // Specialized function for each realization (easy to extend for non-int/double).
 };
@@ -46,7 +86,8 @@ protected:
 /*** Constructor definition ***/
 
 template <typename T, class V>
-Csparse_matrix<T, V>::Csparse_matrix(const Rcpp::RObject& incoming) : original(incoming), currow(0), curstart(0), curend(this->ncol) {
+Csparse_matrix<T, V>::Csparse_matrix(const Rcpp::RObject& incoming) : original(incoming), 
+        row_index_requested(false), row_index_limit(0) {
     std::string ctype=check_Matrix_class(incoming, "gCMatrix");  
     this->fill_dims(get_safe_slot(incoming, "Dim"));
     const size_t& NC=this->ncol;
@@ -74,11 +115,10 @@ Csparse_matrix<T, V>::Csparse_matrix(const Rcpp::RObject& incoming) : original(i
     if (p[NC]!=x.size()) { throw_custom_error("last element of 'p' in a ", ctype, " object should be 'length(x)'"); }
 
     // Checking all the indices.
-    indices.resize(NC);
     auto pIt=p.begin();
     for (size_t px=0; px<NC; ++px) {
         if (*pIt < 0) { throw_custom_error("'p' slot in a ", ctype, " object should contain non-negative values"); }
-        const int& current=(indices[px]=*pIt); 
+        const int& current=*pIt; 
         if (current > *(++pIt)) { throw_custom_error("'p' slot in a ", ctype, " object should be sorted"); }
     }
 
@@ -103,6 +143,10 @@ Csparse_matrix<T, V>::Csparse_matrix(const Rcpp::RObject& incoming) : original(i
         }
     }
 
+    iptr=i.begin();
+    pptr=p.begin();
+    xptr=x.begin();
+    nnz=x.size();
     return;
 }
 
@@ -114,89 +158,107 @@ Csparse_matrix<T, V>::~Csparse_matrix () {}
 template <typename T, class V>
 T Csparse_matrix<T, V>::get(size_t r, size_t c) {
     check_oneargs(r, c);
-    auto iend=i.begin() + p[c+1];
-    auto loc=std::lower_bound(i.begin() + p[c], iend, r);
+    auto iend=iptr + pptr[c+1];
+    auto loc=std::lower_bound(iptr + pptr[c], iend, r);
     if (loc!=iend && *loc==r) { 
-        return x[loc - i.begin()];
+        return xptr[loc - iptr];
     } else {
         return get_empty();
     }
 }
 
 template <typename T, class V>
-void Csparse_matrix<T, V>::update_indices(size_t r, size_t first, size_t last) {
-    /* If left/right slice are not equal to what is stored, we reset the indices,
+void Csparse_matrix<T, V>::update_indices(size_t r, size_t first, size_t last, row_cursor& cur) {
+    /* If left/right slice are not equal to what is stored in the cursor, we reset the indices,
      * so that the code below will know to recompute them. It's too much effort
      * to try to figure out exactly which columns need recomputing; just do them all.
+     * The same applies if the cursor was last used with a different matrix.
      */
-    if (first!=curstart || last!=curend) {
-        curstart=first;
-        curend=last;
-        Rcpp::IntegerVector::iterator pIt=p.begin()+first;
-        for (size_t px=first; px<last; ++px, ++pIt) {
-            indices[px]=*pIt; 
-        }
-        currow=0;
+    if (!cur.matches(first, last, iptr, nnz)) {
+        cur.reset(first, last, iptr, nnz);
+        std::copy(pptr+first, pptr+last, cur.indices.begin());
     }
 
     /* entry of 'indices' for each column should contain the index of the first
      * element with row number not less than 'r'. If no such element exists, it
      * will contain the index of the first element of the next column.
+     * Note that 'indices' only spans the slice, so it is offset by 'first'.
      */
-    if (r==currow) { 
+    if (r==cur.row) { 
         return; 
     } 
 
-    Rcpp::IntegerVector::iterator pIt=p.begin()+first;
-    if (r==currow+1) {
+    auto pIt=pptr+first;
+    auto cIt=cur.indices.begin();
+    if (r==cur.row+1) {
         ++pIt; // points to the first-past-the-end element, at any given 'c'.
-        for (size_t c=first; c<last; ++c, ++pIt) {
-            int& curdex=indices[c];
-            if (curdex!=*pIt && i[curdex] < r) { 
+        for (size_t c=first; c<last; ++c, ++pIt, ++cIt) {
+            size_t& curdex=*cIt;
+            if (curdex!=size_t(*pIt) && iptr[curdex] < r) { 
                 ++curdex;
             }
         }
-    } else if (r+1==currow) {
-        for (size_t c=first; c<last; ++c, ++pIt) {
-            int& curdex=indices[c];
-            if (curdex!=*pIt && i[curdex-1] >= r) { 
+    } else if (r+1==cur.row) {
+        for (size_t c=first; c<last; ++c, ++pIt, ++cIt) {
+            size_t& curdex=*cIt;
+            if (curdex!=size_t(*pIt) && iptr[curdex-1] >= r) { 
                 --curdex;
             }
         }
 
     } else { 
-        Rcpp::IntegerVector::iterator istart=i.begin(), loc;
-        if (r > currow) {
+        const int* istart=iptr;
+        const int* loc;
+        if (r > cur.row) {
             ++pIt; // points to the first-past-the-end element, at any given 'c'.
-            for (size_t c=first; c<last; ++c, ++pIt) { 
-                int& curdex=indices[c];
+            for (size_t c=first; c<last; ++c, ++pIt, ++cIt) { 
+                size_t& curdex=*cIt;
                 loc=std::lower_bound(istart + curdex, istart + *pIt, r);
                 curdex=loc - istart;
             }
         } else { 
-            for (size_t c=first; c<last; ++c, ++pIt) {
-                int& curdex=indices[c];
+            for (size_t c=first; c<last; ++c, ++pIt, ++cIt) {
+                size_t& curdex=*cIt;
                 loc=std::lower_bound(istart + *pIt, istart + curdex, r);
                 curdex=loc - istart;
             }
         }
     }
 
-    currow=r;
+    cur.row=r;
     return;
 }
 
 template <typename T, class V>
 template <class Iter>
 void Csparse_matrix<T, V>::get_row(size_t r, Iter out, size_t first, size_t last) {
+    get_row(r, out, first, last, cursor);
+    return;
+}
+
+template <typename T, class V>
+template <class Iter>
+void Csparse_matrix<T, V>::get_row(size_t r, Iter out, size_t first, size_t last, row_cursor& cur) {
     check_rowargs(r, first, last);
-    update_indices(r, first, last);
+    if (prepare_row_index()) {
+        std::fill(out, out+last-first, get_empty());
+        std::vector<int>::const_iterator cIt, cEnd;
+        find_row_range(r, first, last, cIt, cEnd);
+        auto xoIt=rindex->x.begin() + (cIt - rindex->c.begin());
+        for (; cIt!=cEnd; ++cIt, ++xoIt) {
+            *(out + (*cIt - int(first)))=xptr[*xoIt];
+        }
+        return;
+    }
+
+    update_indices(r, first, last, cur);
     std::fill(out, out+last-first, get_empty());
 
-    auto pIt=p.begin()+first+1; // Points to first-past-the-end for each 'c'.
-    for (size_t c=first; c<last; ++c, ++pIt, ++out) { 
-        const int& idex=indices[c];
-        if (idex!=*pIt && i[idex]==r) { (*out)=x[idex]; }
+    auto pIt=pptr+first+1; // Points to first-past-the-end for each 'c'.
+    auto cIt=cur.indices.begin();
+    for (size_t c=first; c<last; ++c, ++pIt, ++cIt, ++out) { 
+        const size_t& idex=*cIt;
+        if (idex!=size_t(*pIt) && iptr[idex]==r) { (*out)=xptr[idex]; }
     } 
     return;  
 }
@@ -205,10 +267,10 @@ template <typename T, class V>
 template <class Iter>
 void Csparse_matrix<T, V>::get_col(size_t c, Iter out, size_t first, size_t last) {
     check_colargs(c, first, last);
-    const int& pstart=p[c]; 
-    auto iIt=i.begin()+pstart, 
-         eIt=i.begin()+p[c+1]; 
-    auto xIt=x.begin()+pstart;
+    const int& pstart=pptr[c]; 
+    auto iIt=iptr+pstart, 
+         eIt=iptr+pptr[c+1]; 
+    auto xIt=xptr+pstart;
 
     if (first) { // Jumping ahead if non-zero.
         auto new_iIt=std::lower_bound(iIt, eIt, first);
@@ -226,20 +288,103 @@ void Csparse_matrix<T, V>::get_col(size_t c, Iter out, size_t first, size_t last
     return;
 }
 
+template <typename T, class V>
+template <class Iter>
+void Csparse_matrix<T, V>::get_cols(size_t first_col, size_t last_col, Iter out, size_t first, size_t last) {
+    check_colsargs(first_col, last_col, first, last);
+    const size_t nvals=last-first;
+    std::fill(out, out+(last_col-first_col)*nvals, get_empty());
+
+    // Scattering the non-zero elements of all columns into the zero-filled block.
+    const bool full=(first==0 && last==(this->nrow));
+    auto pIt=pptr+first_col;
+    for (size_t c=first_col; c<last_col; ++c, ++pIt, out+=nvals) {
+        auto iIt=iptr+*pIt, 
+             eIt=iptr+*(pIt+1);
+        auto xIt=xptr+*pIt;
+
+        if (!full) { 
+            auto new_iIt=std::lower_bound(iIt, eIt, first);
+            xIt+=(new_iIt-iIt);
+            iIt=new_iIt;
+            eIt=std::lower_bound(iIt, eIt, last);
+        }
+
+        for (; iIt!=eIt; ++iIt, ++xIt) {
+            *(out + (*iIt - int(first)))=*xIt;
+        }
+    }
+    return;
+}
+
+template <typename T, class V>
+template <class Iter>
+void Csparse_matrix<T, V>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Iter out) {
+    check_colsubset(c, rows, n);
+    auto istart=iptr, iIt=istart+pptr[c], eIt=istart+pptr[c+1];
+
+    // Galloping through the non-zero row indices, as the requested rows are sorted.
+    for (size_t s=0; s<n; ++s, ++rows, ++out) {
+        iIt=gallop_lower_bound(iIt, eIt, *rows);
+        if (iIt!=eIt && *iIt==*rows) {
+            (*out)=xptr[iIt - istart];
+        } else {
+            (*out)=get_empty();
+        }
+    }
+    return;
+}
+
+template <typename T, class V>
+template <class Iter>
+void Csparse_matrix<T, V>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Iter out) {
+    check_rowsubset(r, cols, n);
+    auto istart=iptr;
+    for (size_t s=0; s<n; ++s, ++cols, ++out) {
+        auto iend=istart + pptr[*cols + 1];
+        auto loc=std::lower_bound(istart + pptr[*cols], iend, r);
+        if (loc!=iend && *loc==r) { 
+            (*out)=xptr[loc - istart];
+        } else {
+            (*out)=get_empty();
+        }
+    }
+    return;
+}
+
 template<typename T, class V>
 template<class Iter>
 size_t Csparse_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator index, Iter val, size_t first, size_t last) {
+    return get_nonzero_row(r, index, val, first, last, cursor);
+}
+
+template<typename T, class V>
+template<class Iter>
+size_t Csparse_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator index, Iter val, size_t first, size_t last, row_cursor& cur) {
     check_rowargs(r, first, last);
-    update_indices(r, first, last);
+    if (prepare_row_index()) {
+        std::vector<int>::const_iterator cIt, cEnd;
+        find_row_range(r, first, last, cIt, cEnd);
+        const size_t nzero=cEnd - cIt;
+        auto xoIt=rindex->x.begin() + (cIt - rindex->c.begin());
+        std::copy(cIt, cEnd, index);
+        for (; cIt!=cEnd; ++cIt, ++xoIt, ++val) {
+            (*val)=xptr[*xoIt];
+        }
+        return nzero;
+    }
+
+    update_indices(r, first, last, cur);
 
-    auto pIt=p.begin()+first+1; // Points to first-past-the-end for each 'c'.
+    auto pIt=pptr+first+1; // Points to first-past-the-end for each 'c'.
+    auto cIt=cur.indices.begin();
     size_t nzero=0;
-    for (size_t c=first; c<last; ++c, ++pIt) { 
-        const int& idex=indices[c];
-        if (idex!=*pIt && i[idex]==r) { 
+    for (size_t c=first; c<last; ++c, ++pIt, ++cIt) { 
+        const size_t& idex=*cIt;
+        if (idex!=size_t(*pIt) && iptr[idex]==r) { 
             ++nzero;
             (*index)=c;
-            (*val)=x[idex];
+            (*val)=xptr[idex];
             ++index;
             ++val;
         }
@@ -252,10 +397,10 @@ template<typename T, class V>
 template<class Iter>
 size_t Csparse_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iterator index, Iter val, size_t first, size_t last) {
     check_colargs(c, first, last);
-    const int& pstart=p[c]; 
-    auto iIt=i.begin()+pstart, 
-         eIt=i.begin()+p[c+1]; 
-    auto xIt=x.begin()+pstart;
+    const int& pstart=pptr[c]; 
+    auto iIt=iptr+pstart, 
+         eIt=iptr+pptr[c+1]; 
+    auto xIt=xptr+pstart;
 
     if (first) { // Jumping ahead if non-zero.
         auto new_iIt=std::lower_bound(iIt, eIt, first);
@@ -273,6 +418,96 @@ size_t Csparse_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iter
     return nzero;
 }
 
+template<typename T, class V>
+size_t Csparse_matrix<T, V>::get_const_nonzero_col(size_t c, Rcpp::IntegerVector::const_iterator& index, typename V::const_iterator& val, size_t first, size_t last) {
+    check_colargs(c, first, last);
+    const int& pstart=pptr[c]; 
+    auto iIt=iptr+pstart, 
+         eIt=iptr+pptr[c+1]; 
+
+    // Pointing directly into the 'i' and 'x' slots, without copying.
+    if (first) { 
+        iIt=std::lower_bound(iIt, eIt, first);
+    } 
+    if (last!=(this->nrow)) { 
+        eIt=std::lower_bound(iIt, eIt, last);
+    }
+
+    index=iIt;
+    val=xptr + (iIt - iptr);
+    return eIt - iIt;
+}
+
+/*** Row index functions ***/
+
+template<typename T, class V>
+void Csparse_matrix<T, V>::enable_row_index(size_t limit) {
+    row_index_requested=true;
+    row_index_limit=limit;
+    prepare_row_index(); // Building it now, so that any subsequent clones share the same index.
+    return;
+}
+
+template<typename T, class V>
+bool Csparse_matrix<T, V>::prepare_row_index() {
+    if (rindex) {
+        return true;
+    } else if (!row_index_requested) { 
+        return false;
+    }
+
+    /* Checking that the index would fit in the specified memory limit.
+     * If not, we fall back to the cursor-based scheme in update_indices().
+     */
+    const size_t& NR=this->nrow;
+    const size_t& NC=this->ncol;
+    if ((NR + 1 + 2*nnz) * sizeof(int) > row_index_limit) {
+        row_index_requested=false;
+        return false;
+    }
+
+    // Counting sort on the row indices; columns are traversed in order, so they are sorted within each row.
+    auto built=std::make_shared<row_index>();
+    auto& row_p=built->p;
+    auto& row_c=built->c;
+    auto& row_x=built->x;
+    row_p.assign(NR+1, 0);
+    for (auto iIt=iptr; iIt!=iptr+nnz; ++iIt) {
+        ++row_p[*iIt + 1];
+    }
+    std::partial_sum(row_p.begin(), row_p.end(), row_p.begin());
+
+    row_c.resize(nnz);
+    row_x.resize(nnz);
+    std::vector<int> position(row_p.begin(), row_p.end()-1);
+    auto pIt=pptr;
+    for (size_t c=0; c<NC; ++c, ++pIt) {
+        for (int ix=*pIt; ix<*(pIt+1); ++ix) {
+            int& curpos=position[iptr[ix]];
+            row_c[curpos]=c;
+            row_x[curpos]=ix;
+            ++curpos;
+        }
+    }
+
+    rindex=built;
+    return true;
+}
+
+template<typename T, class V>
+void Csparse_matrix<T, V>::find_row_range(size_t r, size_t first, size_t last, 
+        std::vector<int>::const_iterator& cIt, std::vector<int>::const_iterator& cEnd) const {
+    cIt=rindex->c.begin() + rindex->p[r];
+    cEnd=rindex->c.begin() + rindex->p[r+1];
+    if (first) { 
+        cIt=std::lower_bound(cIt, cEnd, first);
+    }
+    if (last!=(this->ncol)) { 
+        cEnd=std::lower_bound(cIt, cEnd, last);
+    }
+    return;
+}
+
 template<typename T, class V>
 Rcpp::RObject Csparse_matrix<T, V>::yield() const {
     return original;
@@ -12,7 +12,7 @@ namespace beachmat {
 template<typename T, class V>
 class Csparse_output : public any_matrix {
 public:
-    Csparse_output(size_t, size_t);
+    Csparse_output(size_t, size_t, size_t=0, size_t=1);
     ~Csparse_output();
 
     template <class Iter>
@@ -27,101 +27,149 @@ public:
     void get_row(size_t, Iter, size_t, size_t);
     T get(size_t, size_t);
 
+    void finalize();
+
     Rcpp::RObject yield();
 
     matrix_type get_matrix_type() const;
 private:
-    typedef std::pair<size_t, T> data_pair;
-    std::vector<std::deque<data_pair> > data;
+    /* Each column is stored as separate vectors of sorted row indices and values,
+     * using sizeof(int)+sizeof(T) bytes per non-zero element. If the memory limit is
+     * exceeded, the stored values of all sufficiently large columns are appended to a temporary
+     * file as segments, which also count towards the limit. Values in memory always lie after 
+     * those in the segments of the same column.
+     */
+    struct segment {
+        size_t offset, n; // Row indices at 'offset', followed by the values.
+        int first, last;
+    };
+    struct column {
+        std::vector<int> index;
+        std::vector<T> value;
+        std::vector<segment> spilled;
+    };
+    std::vector<column> data;
+
+    size_t limit, stored, nsegments, retained, nthreads;
+    std::shared_ptr<spill_file> spill;
+
+    /* Column storage is moved into the slots by yield(), after which the slots are
+     * retained and only copied back into the columns if the values are accessed again.
+     */
+    bool frozen;
+    Rcpp::IntegerVector frozen_p, frozen_i;
+    V frozen_x;
+    void thaw();
+
+    /* Out-of-order insertions from set_row() are staged as triplets and merged into the 
+     * columns by finalize(), which is called before any other access to the stored values.
+     */
+    struct triplet {
+        int row, col;
+        T value;
+    };
+    std::vector<triplet> staged;
 
     T get_empty() const;
-    template <class Iter>
-    Iter find_matching_row(Iter, Iter, const data_pair&);
+    static size_t find_matching_row(const column&, size_t);
+    void sort_staged();
+
+    static bool is_empty(const column&);
+    static size_t last_row(const column&);
+    void read_segment(const segment&, int*, T*) const;
+    void load(column&);
+    void check_limit();
+    void spill_large();
+    bool find_value(const column&, size_t, T&) const;
 };
 
 /*** Constructor definition ***/
 
 template<typename T, class V>
-Csparse_output<T, V>::Csparse_output(size_t nr, size_t nc) : any_matrix(nr, nc), data(nc) {}
+Csparse_output<T, V>::Csparse_output(size_t nr, size_t nc, size_t lim, size_t nt) : any_matrix(nr, nc), data(nc), 
+    limit(lim), stored(0), nsegments(0), retained(0), nthreads(std::max(nt, size_t(1))), frozen(false) {}
 
 template<typename T, class V>
 Csparse_output<T, V>::~Csparse_output() {}
 
 /*** Setter methods ***/
 
+template<typename T, class V>
+size_t Csparse_output<T, V>::find_matching_row(const column& current, size_t r) {
+    return std::lower_bound(current.index.begin(), current.index.end(), static_cast<int>(r)) - current.index.begin();
+}
+
 template<typename T, class V>
 template<class Iter>
 void Csparse_output<T, V>::set_col(size_t c, Iter in, size_t first, size_t last) {
     check_colargs(c, first, last);
-    std::deque<data_pair>& current=data[c];
-    std::deque<data_pair> new_set;
-
-    // Filling in all elements before start.
-    auto cIt=current.begin(); 
-    while (cIt!=current.end() && cIt->first < first) {
-        new_set.push_back(*cIt);
-        ++cIt;
+    finalize();
+    column& current=data[c];
+    const size_t before=current.index.size();
+
+    // Appending directly if the new elements lie after all existing elements (e.g., an empty column).
+    if (is_empty(current) || last_row(current) < first) {
+        for (size_t index=first; index<last; ++index, ++in) {
+            if ((*in)!=get_empty()) { 
+                current.index.push_back(index);
+                current.value.push_back(*in);
+            }
+        }
+        stored+=current.index.size() - before;
+        check_limit();
+        return;
     }
-   
-    // Filling in all non-empty elements. 
+    load(current);
+
+    // Otherwise, replacing all existing elements in [first, last) with the new non-empty elements.
+    std::vector<int> new_index;
+    std::vector<T> new_value;
     for (size_t index=first; index<last; ++index, ++in) {
         if ((*in)!=get_empty()) { 
-            new_set.push_back(data_pair(index, *in));
+            new_index.push_back(index);
+            new_value.push_back(*in);
         }
     } 
 
-    // Jumping to the end.
-    while (cIt!=current.end() && cIt->first < last) {
-        ++cIt;
-    }
-
-    // Filling in remaining elements.
-    while (cIt!=current.end()) {
-        new_set.push_back(*cIt);
-        ++cIt;
-    }
-
-    current.swap(new_set);
+    const size_t start=find_matching_row(current, first), end=find_matching_row(current, last);
+    current.index.erase(current.index.begin() + start, current.index.begin() + end);
+    current.index.insert(current.index.begin() + start, new_index.begin(), new_index.end());
+    current.value.erase(current.value.begin() + start, current.value.begin() + end);
+    current.value.insert(current.value.begin() + start, new_value.begin(), new_value.end());
+    stored=stored - end + start + new_index.size();
+    check_limit();
     return;
 }
 
-template<typename T, class V>
-template <class Iter>
-Iter Csparse_output<T, V>::find_matching_row(Iter begin, Iter end, const data_pair& incoming) {
-    return std::lower_bound(begin, end, incoming, 
-            [](const data_pair& lhs, const data_pair& rhs) -> bool { return lhs.first < rhs.first; }); // Using a lambda to only compare first value.
-}
-
 template<typename T, class V>
 template<class Iter>
 void Csparse_output<T, V>::set_row(size_t r, Iter in, size_t first, size_t last) {
     check_rowargs(r, first, last);
+    thaw();
     for (size_t c=first; c<last; ++c, ++in) {
         if ((*in)==get_empty()) { continue; }
 
-        std::deque<data_pair>& current=data[c];
-        if (current.size()) {
-            if (r < current.front().first) {
-                current.push_front(data_pair(r, *in));
-            } else if (r==current.front().first) {
-                current.front().second=*in;
-            } else if (r > current.back().first) {
-                current.push_back(data_pair(r, *in));
-            } else if (r==current.back().first) {
-                current.back().second=*in;
-            } else {
-                data_pair incoming(r, *in);
-                auto insert_loc=find_matching_row(current.begin(), current.end(), incoming);
-                if (insert_loc!=current.end() && insert_loc->first==r) { 
-                    insert_loc->second=*in;
-                } else {
-                    current.insert(insert_loc, incoming);
-                }
+        // Staged triplets are newer than the stored values, so all further insertions must also be staged.
+        column& current=data[c];
+        if (staged.empty()) {
+            if (is_empty(current) || last_row(current) < r) {
+                current.index.push_back(r);
+                current.value.push_back(*in);
+                ++stored;
+                continue;
+            } else if (!current.index.empty() && static_cast<size_t>(current.index.back())==r) {
+                current.value.back()=*in;
+                continue;
             }
-        } else {
-            current.push_back(data_pair(r, *in));
         }
+
+        triplet incoming;
+        incoming.row=r;
+        incoming.col=c;
+        incoming.value=*in;
+        staged.push_back(incoming);
     }
+    check_limit();
     return;
 }
 
@@ -138,22 +186,13 @@ template<typename T, class V>
 template<class Iter>
 void Csparse_output<T, V>::get_row(size_t r, Iter out, size_t first, size_t last) {
     check_rowargs(r, first, last);
+    finalize();
     std::fill(out, out+last-first, get_empty());
 
+    T val;
     for (size_t col=first; col<last; ++col, ++out) {
-        const std::deque<data_pair>& current=data[col];
-        if (current.empty() || r>current.back().first || r<current.front().first) {
-            continue; 
-        }
-        if (r==current.back().first) { 
-            (*out)=current.back().second;
-        } else if (r==current.front().first) {
-            (*out)=current.front().second;
-        } else {
-            auto loc=find_matching_row(current.begin(), current.end(), data_pair(r, *out)); // Equivalent to get_empty(), due to fill.
-            if (loc!=current.end() && loc->first==r) { 
-                (*out)=loc->second;
-            }
+        if (find_value(data[col], r, val)) {
+            (*out)=val;
         }
     }
     return;
@@ -163,18 +202,34 @@ template<typename T, class V>
 template<class Iter>
 void Csparse_output<T, V>::get_col(size_t c, Iter out, size_t first, size_t last) {
     check_colargs(c, first, last);
-    const std::deque<data_pair>& current=data[c];
+    finalize();
+    const column& current=data[c];
+    std::fill(out, out+last-first, get_empty());
 
-    // Jumping forwards.
-    auto cIt=current.begin();
-    if (first) {
-        cIt=find_matching_row(current.begin(), current.end(), data_pair(first, get_empty()));
+    // Reading overlapping segments from file, without loading them into memory.
+    std::vector<int> seg_index;
+    std::vector<T> seg_value;
+    for (const auto& seg : current.spilled) {
+        if (static_cast<size_t>(seg.last) < first || static_cast<size_t>(seg.first) >= last) {
+            continue;
+        }
+        seg_index.resize(seg.n);
+        seg_value.resize(seg.n);
+        read_segment(seg, seg_index.data(), seg_value.data());
+        for (size_t i=0; i<seg.n; ++i) {
+            const size_t r=seg_index[i];
+            if (r >= first && r < last) {
+                *(out + (r - first)) = seg_value[i];
+            }
+        }
     }
-    
-    std::fill(out, out+last-first, get_empty());
-    while (cIt!=current.end() && cIt->first < last) { 
-        *(out + (cIt->first - first)) = cIt->second;
-        ++cIt;
+
+    // Jumping forwards.
+    size_t loc=(first ? find_matching_row(current, first) : 0);
+    const size_t nnzero=current.index.size();
+    while (loc < nnzero && static_cast<size_t>(current.index[loc]) < last) { 
+        *(out + (current.index[loc] - first)) = current.value[loc];
+        ++loc;
     }
     return;
 }
@@ -182,13 +237,234 @@ void Csparse_output<T, V>::get_col(size_t c, Iter out, size_t first, size_t last
 template<typename T, class V>
 T Csparse_output<T, V>::get(size_t r, size_t c) {
     check_oneargs(r, c);
-    const std::deque<data_pair>& current=data[c];
-    auto cIt=find_matching_row(current.begin(), current.end(), data_pair(r, get_empty()));
-    if (cIt!=current.end() && cIt->first==r) {
-        return cIt->second;
-    } else {
-        return get_empty();
+    finalize();
+    T out=get_empty();
+    find_value(data[c], r, out);
+    return out;
+}
+
+/* Finding the value for row 'r' in a column, searching the segment containing 'r' if it is not in memory. 
+ * 'out' is left unchanged and false is returned if there is no value for 'r'.
+ */
+
+template<typename T, class V>
+bool Csparse_output<T, V>::find_value(const column& current, size_t r, T& out) const {
+    if (!current.index.empty() && r >= static_cast<size_t>(current.index.front())) {
+        if (r==static_cast<size_t>(current.index.back())) { 
+            out=current.value.back();
+            return true;
+        }
+        const size_t loc=find_matching_row(current, r);
+        if (loc < current.index.size() && static_cast<size_t>(current.index[loc])==r) { 
+            out=current.value[loc];
+            return true;
+        }
+        return false;
+    }
+
+    for (const auto& seg : current.spilled) {
+        if (r < static_cast<size_t>(seg.first) || r > static_cast<size_t>(seg.last)) {
+            continue;
+        }
+        std::vector<int> seg_index(seg.n);
+        spill->read(seg.offset, reinterpret_cast<char*>(seg_index.data()), seg.n*sizeof(int));
+        auto it=std::lower_bound(seg_index.begin(), seg_index.end(), static_cast<int>(r));
+        if (it!=seg_index.end() && static_cast<size_t>(*it)==r) {
+            const size_t pos=it - seg_index.begin();
+            spill->read(seg.offset + seg.n*sizeof(int) + pos*sizeof(T), reinterpret_cast<char*>(&out), sizeof(T));
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+/*** Spilling to file ***/
+
+template<typename T, class V>
+bool Csparse_output<T, V>::is_empty(const column& current) {
+    return current.index.empty() && current.spilled.empty();
+}
+
+template<typename T, class V>
+size_t Csparse_output<T, V>::last_row(const column& current) {
+    return (current.index.empty() ? current.spilled.back().last : current.index.back());
+}
+
+template<typename T, class V>
+void Csparse_output<T, V>::read_segment(const segment& seg, int* index, T* value) const {
+    spill->read(seg.offset, reinterpret_cast<char*>(index), seg.n*sizeof(int));
+    spill->read(seg.offset + seg.n*sizeof(int), reinterpret_cast<char*>(value), seg.n*sizeof(T));
+    return;
+}
+
+/* Loading all segments of a column back into memory, for modifications that do not simply append.
+ * The space in the file is not reused, as the file is only ever appended to.
+ */
+
+template<typename T, class V>
+void Csparse_output<T, V>::load(column& current) {
+    if (current.spilled.empty()) {
+        return;
+    }
+    size_t total=current.index.size();
+    for (const auto& seg : current.spilled) {
+        total+=seg.n;
     }
+    std::vector<int> new_index(total);
+    std::vector<T> new_value(total);
+    size_t pos=0;
+    for (const auto& seg : current.spilled) {
+        read_segment(seg, new_index.data() + pos, new_value.data() + pos);
+        pos+=seg.n;
+    }
+    std::copy(current.index.begin(), current.index.end(), new_index.begin() + pos);
+    std::copy(current.value.begin(), current.value.end(), new_value.begin() + pos);
+
+    stored+=pos;
+    nsegments-=current.spilled.size();
+    current.index.swap(new_index);
+    current.value.swap(new_value);
+    std::vector<segment>().swap(current.spilled);
+    return;
+}
+
+/* Spilling values once the limit is exceeded, where the memory used to record spilled segments also 
+ * counts towards the limit. Values are always allowed at least half of the limit, so that segments 
+ * do not become progressively smaller as the number of segments increases. If the previous spill 
+ * left many values in small columns, another spill is only attempted after a further half of the 
+ * limit has been used, to avoid scanning all columns upon every insertion.
+ */
+
+template<typename T, class V>
+void Csparse_output<T, V>::check_limit() {
+    if (limit==0) {
+        return;
+    }
+    const size_t used=staged.size()*sizeof(triplet) + stored*(sizeof(int) + sizeof(T));
+    const size_t metadata=nsegments*sizeof(segment);
+    if (used > std::max(limit - std::min(limit, metadata), retained + limit/2)) {
+        finalize();
+        spill_large();
+    }
+    return;
+}
+
+/* Spilling all columns that are large enough to justify a segment, as each segment requires 
+ * its own metadata and read. Staged triplets are merged first, as they cannot be spilled directly.
+ */
+
+template<typename T, class V>
+void Csparse_output<T, V>::spill_large() {
+    const size_t minimum=4*sizeof(segment);
+    for (auto& current : data) {
+        if (current.index.size()*(sizeof(int) + sizeof(T)) < minimum) {
+            continue;
+        }
+        if (!spill) {
+            spill=std::make_shared<spill_file>();
+        }
+        segment seg;
+        seg.n=current.index.size();
+        seg.first=current.index.front();
+        seg.last=current.index.back();
+        seg.offset=spill->append(reinterpret_cast<const char*>(current.index.data()), seg.n*sizeof(int));
+        spill->append(reinterpret_cast<const char*>(current.value.data()), seg.n*sizeof(T));
+        current.spilled.push_back(seg);
+        ++nsegments;
+        stored-=seg.n;
+
+        std::vector<int>().swap(current.index); // Releasing the memory.
+        std::vector<T>().swap(current.value);
+    }
+    retained=stored*(sizeof(int) + sizeof(T));
+    return;
+}
+
+/*** Merging staged values ***/
+
+/* Sorting the staged triplets by column and then row, using two passes of a stable 
+ * counting sort (i.e., a LSD radix sort) such that the insertion order is preserved 
+ * for triplets with the same row and column.
+ */
+
+template<typename T, class V>
+void Csparse_output<T, V>::sort_staged() {
+    std::vector<triplet> sorted(staged.size());
+    std::vector<size_t> counts;
+
+    auto counting_sort=[&](const std::vector<triplet>& source, std::vector<triplet>& dest, size_t nbuckets, bool bycol) -> void {
+        counts.assign(nbuckets+1, 0);
+        for (const auto& x : source) {
+            ++counts[(bycol ? x.col : x.row)+1];
+        }
+        std::partial_sum(counts.begin(), counts.end(), counts.begin());
+        for (const auto& x : source) {
+            dest[counts[(bycol ? x.col : x.row)]++]=x;
+        }
+        return;
+    };
+
+    counting_sort(staged, sorted, this->nrow, false);
+    counting_sort(sorted, staged, this->ncol, true);
+    return;
+}
+
+template<typename T, class V>
+void Csparse_output<T, V>::finalize() {
+    thaw();
+    if (staged.empty()) {
+        return;
+    }
+    sort_staged();
+
+    // Merging the staged triplets for each column, where the last staged value for a row takes precedence.
+    std::vector<int> new_index;
+    std::vector<T> new_value;
+    auto sIt=staged.begin();
+    while (sIt!=staged.end()) {
+        column& current=data[sIt->col];
+        auto sEnd=sIt;
+        while (sEnd!=staged.end() && sEnd->col==sIt->col) {
+            ++sEnd;
+        }
+
+        if (!current.spilled.empty() && static_cast<size_t>(sIt->row) <= last_row(current)) {
+            load(current);
+        }
+        const size_t before=current.index.size();
+
+        new_index.clear();
+        new_value.clear();
+        auto iIt=current.index.begin();
+        auto vIt=current.value.begin();
+        for (; sIt!=sEnd; ++sIt) {
+            if (sIt+1!=sEnd && (sIt+1)->row==sIt->row) {
+                continue;
+            }
+            while (iIt!=current.index.end() && *iIt < sIt->row) {
+                new_index.push_back(*iIt);
+                new_value.push_back(*vIt);
+                ++iIt;
+                ++vIt;
+            }
+            if (iIt!=current.index.end() && *iIt==sIt->row) {
+                ++iIt;
+                ++vIt;
+            }
+            new_index.push_back(sIt->row);
+            new_value.push_back(sIt->value);
+        }
+        new_index.insert(new_index.end(), iIt, current.index.end());
+        new_value.insert(new_value.end(), vIt, current.value.end());
+
+        current.index.swap(new_index);
+        current.value.swap(new_value);
+        stored=stored - before + current.index.size();
+    }
+
+    std::vector<triplet>().swap(staged); // Releasing the memory.
+    return;
 }
 
 /*** Output function ***/
@@ -210,6 +486,7 @@ Rcpp::RObject Csparse_output<T, V>::yield() {
             throw std::runtime_error(err.str().c_str());
     }
     Rcpp::S4 mat(classname);
+    finalize();
 
     // Setting dimensions.
     if (!mat.hasSlot("Dim")) {
@@ -225,7 +502,10 @@ Rcpp::RObject Csparse_output<T, V>::yield() {
     auto pIt=p.begin()+1;
     size_t total_size=0;
     for (auto dIt=data.begin(); dIt!=data.end(); ++dIt, ++pIt) { 
-        total_size+=dIt->size();
+        total_size+=dIt->index.size();
+        for (const auto& seg : dIt->spilled) {
+            total_size+=seg.n;
+        }
         (*pIt)=total_size;
     }
     mat.slot("p")=p;
@@ -239,21 +519,111 @@ Rcpp::RObject Csparse_output<T, V>::yield() {
     if (!mat.hasSlot("x")) {
         throw_custom_error("missing 'x' slot in ", classname, " object");
     }
-    auto xIt=x.begin();
-    auto iIt=i.begin();
-    for (size_t c=0; c<this->ncol; ++c) {
-        auto current=data[c];
-        for (auto cIt=current.begin(); cIt!=current.end(); ++cIt, ++xIt, ++iIt) {
-            (*iIt)=cIt->first;
-            (*xIt)=cIt->second;
+
+    /* Moving each column into the slots and releasing its memory immediately. Columns are split 
+     * into contiguous ranges with similar numbers of non-zero elements, which are processed in parallel
+     * as the output offsets are already known from 'p'. Spilled values are streamed directly from file.
+     * If any worker fails, the columns that were already moved are restored from the slots, so that 
+     * the object still holds all of its values and yield() can be retried.
+     */
+    int* iptr=&(*i.begin());
+    T* xptr=&(*x.begin());
+    const int* pptr=&(*p.begin());
+    const size_t nworkers=std::max(size_t(1), std::min(nthreads, this->ncol));
+    std::vector<size_t> bounds(nworkers+1, this->ncol);
+    bounds[0]=0;
+    for (size_t w=1; w<nworkers; ++w) {
+        bounds[w]=std::lower_bound(pptr, pptr + this->ncol, total_size*w/nworkers) - pptr;
+    }
+
+    std::exception_ptr failure;
+    std::mutex failure_lock;
+    std::vector<size_t> progress(bounds.begin(), bounds.end()-1); // first column not yet moved by each worker.
+    auto work=[&](size_t w) -> void {
+        try {
+            for (size_t c=bounds[w]; c<bounds[w+1]; ++c) {
+                column& current=data[c];
+                size_t pos=pptr[c];
+                for (const auto& seg : current.spilled) {
+                    read_segment(seg, iptr + pos, xptr + pos);
+                    pos+=seg.n;
+                }
+                std::copy(current.index.begin(), current.index.end(), iptr + pos);
+                std::copy(current.value.begin(), current.value.end(), xptr + pos);
+
+                std::vector<int>().swap(current.index); 
+                std::vector<T>().swap(current.value);
+                std::vector<segment>().swap(current.spilled);
+                progress[w]=c+1;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(failure_lock);
+            if (!failure) {
+                failure=std::current_exception();
+            }
+        }
+        return;
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t w=1; w<nworkers; ++w) {
+        pool.push_back(std::thread(work, w));
+    }
+    work(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    if (failure) {
+        stored=0;
+        for (size_t w=0; w<nworkers; ++w) {
+            for (size_t c=bounds[w]; c<progress[w]; ++c) {
+                column& current=data[c];
+                current.index.assign(iptr + pptr[c], iptr + pptr[c+1]);
+                current.value.assign(xptr + pptr[c], xptr + pptr[c+1]);
+            }
         }
+        nsegments=0;
+        for (const auto& current : data) {
+            stored+=current.index.size();
+            nsegments+=current.spilled.size();
+        }
+        std::rethrow_exception(failure);
     }
+    stored=0;
+    nsegments=0;
+    retained=0;
+
     mat.slot("i")=i;
     mat.slot("x")=x;
-
+    frozen_p=p;
+    frozen_i=i;
+    frozen_x=x;
+    frozen=true;
     return SEXP(mat);
 }
 
+/* Copying the retained slots back into the columns, if the values are needed after yield(). */
+
+template<typename T, class V>
+void Csparse_output<T, V>::thaw() {
+    if (!frozen) {
+        return;
+    }
+    frozen=false;
+    for (size_t c=0; c<this->ncol; ++c) {
+        column& current=data[c];
+        current.index.assign(frozen_i.begin() + frozen_p[c], frozen_i.begin() + frozen_p[c+1]);
+        current.value.assign(frozen_x.begin() + frozen_p[c], frozen_x.begin() + frozen_p[c+1]);
+        stored+=current.index.size();
+    }
+    frozen_p=Rcpp::IntegerVector(0);
+    frozen_i=Rcpp::IntegerVector(0);
+    frozen_x=V(0);
+    check_limit();
+    return;
+}
+
 template<typename T, class V>
 matrix_type Csparse_output<T, V>::get_matrix_type() const {
     return SPARSE;
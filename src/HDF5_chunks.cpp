@@ -0,0 +1,709 @@
+#include "HDF5_chunks.h"
+#include "zlib.h"
+#include <sys/stat.h>
+
+namespace beachmat {
+
+/* Methods for the shared chunk cache. */
+
+bool HDF5_chunk_cache::key::operator<(const key& other) const {
+    return std::tie(file, name, modified, modified_ns, filesize, inode, chunk_row, chunk_col) <
+        std::tie(other.file, other.name, other.modified, other.modified_ns, other.filesize, other.inode, other.chunk_row, other.chunk_col);
+}
+
+HDF5_chunk_cache::HDF5_chunk_cache() : limit(2000000000), used(0) {}
+
+HDF5_chunk_cache& HDF5_chunk_cache::get_global() {
+    static HDF5_chunk_cache global;
+    return global;
+}
+
+HDF5_chunk_cache::chunk_ptr HDF5_chunk_cache::get(const key& k) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto it=chunks.find(k);
+    if (it==chunks.end()) {
+        return chunk_ptr();
+    }
+    order.splice(order.begin(), order, it->second.pos); // Moving to the front, as the most recently used.
+    return it->second.data;
+}
+
+void HDF5_chunk_cache::insert(const key& k, chunk_ptr data) {
+    std::lock_guard<std::mutex> lk(lock);
+    if (data->size() > limit || chunks.find(k)!=chunks.end()) {
+        return; // Another thread may have inserted the same chunk in the meantime.
+    }
+    order.push_front(k);
+    entry& current=chunks[k];
+    current.data=data;
+    current.pos=order.begin();
+    used+=data->size();
+    evict();
+    return;
+}
+
+// Removing all chunks from a file, e.g., after it has been modified.
+void HDF5_chunk_cache::invalidate(const std::string& file) {
+    std::lock_guard<std::mutex> lk(lock);
+    for (auto it=order.begin(); it!=order.end(); ) {
+        if (it->file!=file) {
+            ++it;
+            continue;
+        }
+        auto cIt=chunks.find(*it);
+        used-=cIt->second.data->size();
+        chunks.erase(cIt);
+        it=order.erase(it);
+    }
+    return;
+}
+
+void HDF5_chunk_cache::evict() {
+    while (used > limit && !order.empty()) {
+        auto it=chunks.find(order.back());
+        used-=it->second.data->size();
+        chunks.erase(it);
+        order.pop_back();
+    }
+    return;
+}
+
+void HDF5_chunk_cache::set_limit(size_t l) {
+    std::lock_guard<std::mutex> lk(lock);
+    limit=l;
+    evict();
+    return;
+}
+
+size_t HDF5_chunk_cache::get_limit() const {
+    std::lock_guard<std::mutex> lk(lock);
+    return limit;
+}
+
+size_t HDF5_chunk_cache::get_used() const {
+    std::lock_guard<std::mutex> lk(lock);
+    return used;
+}
+
+void HDF5_chunk_cache::clear() {
+    std::lock_guard<std::mutex> lk(lock);
+    chunks.clear();
+    order.clear();
+    used=0;
+    return;
+}
+
+/* Methods for the chunk engine. The engine is left inactive if the data set
+ * does not satisfy the requirements, in which case the usual HDF5 reads are used.
+ */
+
+HDF5_chunk_engine::HDF5_chunk_engine() : active(false), caching(false), checked_id(H5I_INVALID_HID), checked_result(false),
+    nrow(0), ncol(0), elsize(0), chunk_nr(0), chunk_nc(0) {}
+
+void HDF5_chunk_engine::initialize(const std::string& file, const std::string& name, const H5::DataSet& hdata,
+        const H5::DataType& default_type, size_t NR, size_t NC, size_t limit, bool use_cache) {
+    active=false;
+#if H5_VERSION_GE(1, 10, 3)
+    const H5::DSetCreatPropList cparms=hdata.getCreatePlist();
+    if (cparms.getLayout()!=H5D_CHUNKED || !(hdata.getDataType()==default_type)) {
+        return;
+    }
+    if (default_type.getClass()==H5T_STRING && default_type.isVariableStr()) {
+        return; // Raw chunks only contain references to the heap.
+    }
+
+    filters.clear();
+    const int nfilters=cparms.getNfilters();
+    for (int f=0; f<nfilters; ++f) {
+        unsigned int flags, config, cd_values[8];
+        size_t cd_nelmts=8;
+        char fname[64];
+        const H5Z_filter_t curfilter=cparms.getFilter(f, flags, cd_nelmts, cd_values, 64, fname, config);
+        if (curfilter!=H5Z_FILTER_DEFLATE && curfilter!=H5Z_FILTER_SHUFFLE) {
+            return;
+        }
+        filters.push_back(curfilter);
+    }
+
+    hsize_t chunk_dims[2];
+    cparms.getChunk(2, chunk_dims);
+    chunk_nc=chunk_dims[0]; // Data are transposed in the file.
+    chunk_nr=chunk_dims[1];
+
+    type.copy(default_type);
+    checked_id=default_type.getId();
+    checked_result=true;
+    elsize=default_type.getSize();
+    nrow=NR;
+    ncol=NC;
+
+    current.file=file;
+    current.name=name;
+    struct stat info;
+    if (stat(file.c_str(), &info)==0) {
+        current.modified=info.st_mtime;
+#if defined(__APPLE__)
+        current.modified_ns=info.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+        current.modified_ns=0; // Not available; rely on invalidate() instead.
+#else
+        current.modified_ns=info.st_mtim.tv_nsec;
+#endif
+        current.filesize=info.st_size;
+        current.inode=info.st_ino;
+    } else {
+        current.modified=current.modified_ns=current.filesize=current.inode=-1;
+    }
+
+    caching=use_cache;
+    if (caching) {
+        HDF5_chunk_cache::get_global().set_limit(limit);
+    }
+    active=true;
+#endif
+    return;
+}
+
+bool HDF5_chunk_engine::is_active() const {
+    return active;
+}
+
+bool HDF5_chunk_engine::is_caching() const {
+    return active && caching;
+}
+
+/* Checking whether the requested memory type is the same as the file type, 
+ * in which case no conversion is required. The result is remembered for the
+ * last type, to avoid acquiring the HDF5 lock on every call.
+ */
+
+bool HDF5_chunk_engine::uses(const H5::DataType& HDT) {
+    if (HDT.getId()!=checked_id) {
+        std::lock_guard<std::mutex> hlock(get_HDF5_mutex());
+        checked_result=(HDT==type);
+        checked_id=HDT.getId();
+    }
+    return checked_result;
+}
+
+void HDF5_chunk_engine::extract_row(size_t r, size_t first, size_t last, char* out, const H5::DataSet& hdata) {
+    const size_t chunk_row=r/chunk_nr, local_row=r%chunk_nr;
+    while (first < last) {
+        const size_t chunk_col=first/chunk_nc, local_col=first%chunk_nc;
+        const size_t n=std::min(last - first, chunk_nc - local_col);
+        auto chunk=get_chunk(chunk_row, chunk_col, hdata);
+
+        // Each chunk is stored with rows as the fastest-changing dimension.
+        const char* src=chunk->data() + (local_col*chunk_nr + local_row)*elsize;
+        for (size_t i=0; i<n; ++i, src+=chunk_nr*elsize, out+=elsize) {
+            std::copy(src, src+elsize, out);
+        }
+        first+=n;
+    }
+    return;
+}
+
+void HDF5_chunk_engine::extract_col(size_t c, size_t first, size_t last, char* out, const H5::DataSet& hdata) {
+    const size_t chunk_col=c/chunk_nc, local_col=c%chunk_nc;
+    while (first < last) {
+        const size_t chunk_row=first/chunk_nr, local_row=first%chunk_nr;
+        const size_t n=std::min(last - first, chunk_nr - local_row);
+        auto chunk=get_chunk(chunk_row, chunk_col, hdata);
+
+        const char* src=chunk->data() + (local_col*chunk_nr + local_row)*elsize;
+        std::copy(src, src + n*elsize, out);
+        out+=n*elsize;
+        first+=n;
+    }
+    return;
+}
+
+void HDF5_chunk_engine::extract_one(size_t r, size_t c, char* out, const H5::DataSet& hdata) {
+    auto chunk=get_chunk(r/chunk_nr, c/chunk_nc, hdata);
+    const char* src=chunk->data() + ((c%chunk_nc)*chunk_nr + r%chunk_nr)*elsize;
+    std::copy(src, src+elsize, out);
+    return;
+}
+
+/* Parallel extraction of a block of rows [first_row, last_row) and columns [first_col, last_col).
+ * All chunks overlapping the block are enumerated and distributed across a pool of workers,
+ * which read each raw chunk (holding the HDF5 lock) and decompress it (without the lock).
+ * Each chunk is copied into a disjoint part of the column-major output, so no further
+ * synchronization is required. The calling thread also acts as one of the workers.
+ */
+
+void HDF5_chunk_engine::extract_block(size_t first_row, size_t last_row, size_t first_col, size_t last_col, 
+        char* out, const H5::DataSet& hdata, size_t nthreads) {
+    if (first_row>=last_row || first_col>=last_col) {
+        return;
+    }
+    const size_t start_crow=first_row/chunk_nr, end_crow=(last_row-1)/chunk_nr + 1;
+    const size_t start_ccol=first_col/chunk_nc, end_ccol=(last_col-1)/chunk_nc + 1;
+    const size_t nrows_per_crow=end_crow - start_crow;
+    const size_t nchunks=nrows_per_crow*(end_ccol - start_ccol);
+    const size_t out_nr=last_row - first_row;
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr failure;
+    std::mutex failure_lock;
+
+    auto work=[&]() -> void {
+        HDF5_chunk_cache::key k=current;
+        while (true) {
+            const size_t i=next++;
+            if (i>=nchunks) {
+                break;
+            }
+            try {
+                k.chunk_row=start_crow + i%nrows_per_crow;
+                k.chunk_col=start_ccol + i/nrows_per_crow;
+                auto chunk=fetch_chunk(k, hdata);
+
+                const size_t row_start=std::max(first_row, k.chunk_row*chunk_nr);
+                const size_t row_end=std::min(last_row, (k.chunk_row+1)*chunk_nr);
+                const size_t col_start=std::max(first_col, k.chunk_col*chunk_nc);
+                const size_t col_end=std::min(last_col, (k.chunk_col+1)*chunk_nc);
+                const size_t nbytes=(row_end - row_start)*elsize;
+
+                for (size_t c=col_start; c<col_end; ++c) {
+                    const char* src=chunk->data() + ((c - k.chunk_col*chunk_nc)*chunk_nr + row_start - k.chunk_row*chunk_nr)*elsize;
+                    std::copy(src, src + nbytes, out + ((c - first_col)*out_nr + row_start - first_row)*elsize);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lk(failure_lock);
+                if (!failure) {
+                    failure=std::current_exception();
+                }
+                next=nchunks; // Stopping the other workers as soon as possible.
+            }
+        }
+        return;
+    };
+
+    std::vector<std::thread> pool;
+    const size_t nworkers=std::min(nthreads, nchunks);
+    for (size_t t=1; t<nworkers; ++t) {
+        pool.push_back(std::thread(work));
+    }
+    work();
+    for (auto& p : pool) {
+        p.join();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return;
+}
+
+HDF5_chunk_cache::chunk_ptr HDF5_chunk_engine::get_chunk(size_t chunk_row, size_t chunk_col, const H5::DataSet& hdata) {
+    current.chunk_row=chunk_row;
+    current.chunk_col=chunk_col;
+    return fetch_chunk(current, hdata);
+}
+
+/* Decompression is performed without holding the HDF5 lock, so that multiple threads
+ * can decompress different chunks at the same time. Filters are reversed in the opposite
+ * order to which they were applied, skipping those that were not applied to this chunk.
+ */
+
+HDF5_chunk_cache::chunk_ptr HDF5_chunk_engine::fetch_chunk(const HDF5_chunk_cache::key& k, const H5::DataSet& hdata) {
+    HDF5_chunk_cache& cache=HDF5_chunk_cache::get_global();
+    if (caching) {
+        auto found=cache.get(k);
+        if (found) {
+            return found;
+        }
+    }
+
+    std::vector<char> raw;
+    uint32_t mask=0;
+    read_chunk(k.chunk_row, k.chunk_col, raw, mask, hdata);
+
+    const size_t expected=chunk_nr*chunk_nc*elsize;
+    std::vector<char> work;
+    for (size_t f=filters.size(); f>0; --f) {
+        if (mask & (1u << (f-1))) {
+            continue;
+        }
+
+        if (filters[f-1]==H5Z_FILTER_DEFLATE) {
+            work.resize(expected);
+            uLongf outsize=expected;
+            if (uncompress(reinterpret_cast<Bytef*>(work.data()), &outsize,
+                        reinterpret_cast<const Bytef*>(raw.data()), raw.size())!=Z_OK || outsize!=expected) {
+                throw std::runtime_error("failed to decompress HDF5 chunk");
+            }
+        } else {
+            // Reversing the shuffle, which groups the i-th byte of every element together.
+            work.resize(raw.size());
+            const size_t nelements=raw.size()/elsize;
+            const char* src=raw.data();
+            for (size_t b=0; b<elsize; ++b) {
+                for (size_t e=0; e<nelements; ++e, ++src) {
+                    work[e*elsize + b]=*src;
+                }
+            }
+            std::copy(raw.begin() + nelements*elsize, raw.end(), work.begin() + nelements*elsize);
+        }
+        raw.swap(work);
+    }
+
+    if (raw.size()!=expected) {
+        throw std::runtime_error("unexpected size for decompressed HDF5 chunk");
+    }
+    auto output=std::make_shared<const std::vector<char> >(std::move(raw));
+    if (caching) {
+        cache.insert(k, output);
+    }
+    return output;
+}
+
+void HDF5_chunk_engine::read_chunk(size_t chunk_row, size_t chunk_col, std::vector<char>& raw, uint32_t& mask, const H5::DataSet& hdata) {
+    std::lock_guard<std::mutex> hlock(get_HDF5_mutex());
+#if H5_VERSION_GE(1, 10, 3)
+    hsize_t offset[2];
+    offset[0]=chunk_col*chunk_nc;
+    offset[1]=chunk_row*chunk_nr;
+
+    hsize_t nbytes=0;
+    herr_t status=-1;
+    H5E_BEGIN_TRY {
+        status=H5Dget_chunk_storage_size(hdata.getId(), offset, &nbytes);
+    } H5E_END_TRY;
+
+    if (status>=0 && nbytes>0) {
+        raw.resize(nbytes);
+        if (H5Dread_chunk(hdata.getId(), H5P_DEFAULT, offset, &mask, raw.data()) < 0) {
+            throw std::runtime_error("failed to read raw HDF5 chunk");
+        }
+        return;
+    }
+
+    // Unallocated chunks are read through the library to obtain the fill value.
+    hsize_t count[2], full[2];
+    full[0]=chunk_nc;
+    full[1]=chunk_nr;
+    count[0]=std::min(hsize_t(chunk_nc), ncol - offset[0]);
+    count[1]=std::min(hsize_t(chunk_nr), nrow - offset[1]);
+
+    H5::DataSpace filespace=hdata.getSpace();
+    filespace.selectHyperslab(H5S_SELECT_SET, count, offset);
+    H5::DataSpace memspace(2, full);
+    hsize_t zero[2]={0, 0};
+    memspace.selectHyperslab(H5S_SELECT_SET, count, zero);
+    raw.resize(chunk_nr*chunk_nc*elsize);
+    hdata.read(raw.data(), type, memspace, filespace);
+    mask=~uint32_t(0); // Marking all filters as skipped, as the data are already decoded.
+#endif
+    return;
+}
+
+/* Methods for the pipelined chunk writer. The writer is left inactive if the data set
+ * does not satisfy the requirements, in which case the usual HDF5 writes should be used.
+ */
+
+HDF5_chunk_writer::HDF5_chunk_writer() : active(false), shuffle(false), locking(false), level(0), nrow(0), ncol(0), elsize(0), 
+    chunk_nr(1), chunk_nc(1), nthreads(1), budget(0), stopping(false) {}
+
+HDF5_chunk_writer::~HDF5_chunk_writer() {
+    stop();
+}
+
+HDF5_chunk_writer::HDF5_chunk_writer(const HDF5_chunk_writer& other) : active(other.active), shuffle(other.shuffle), 
+    locking(other.locking), level(other.level), nrow(other.nrow), ncol(other.ncol), elsize(other.elsize), chunk_nr(other.chunk_nr), 
+    chunk_nc(other.chunk_nc), nthreads(other.nthreads), budget(other.budget), target(other.target), stopping(false) {}
+
+HDF5_chunk_writer& HDF5_chunk_writer::operator=(const HDF5_chunk_writer& other) {
+    stop();
+    active=other.active;
+    shuffle=other.shuffle;
+    locking=other.locking;
+    level=other.level;
+    nrow=other.nrow;
+    ncol=other.ncol;
+    elsize=other.elsize;
+    chunk_nr=other.chunk_nr;
+    chunk_nc=other.chunk_nc;
+    nthreads=other.nthreads;
+    budget=other.budget;
+    target=other.target;
+    return *this;
+}
+
+void HDF5_chunk_writer::initialize(const H5::DataSet& hdata, const H5::DataType& default_type, size_t NR, size_t NC, 
+        size_t threads, size_t limit, bool lock_commits) {
+    stop();
+    active=false;
+    locking=lock_commits;
+#if H5_VERSION_GE(1, 10, 3)
+    const H5::DSetCreatPropList cparms=hdata.getCreatePlist();
+    if (cparms.getLayout()!=H5D_CHUNKED || !(hdata.getDataType()==default_type)) {
+        return;
+    }
+    if (default_type.getClass()==H5T_STRING && default_type.isVariableStr()) {
+        return;
+    }
+
+    // Only supporting deflate as the last filter, possibly preceded by shuffle.
+    const int nfilters=cparms.getNfilters();
+    if (nfilters < 1 || nfilters > 2) {
+        return;
+    }
+    for (int f=0; f<nfilters; ++f) {
+        unsigned int flags, config, cd_values[8];
+        size_t cd_nelmts=8;
+        char fname[64];
+        const H5Z_filter_t curfilter=cparms.getFilter(f, flags, cd_nelmts, cd_values, 64, fname, config);
+        if (f==nfilters-1) {
+            if (curfilter!=H5Z_FILTER_DEFLATE) {
+                return;
+            }
+            level=(cd_nelmts > 0 ? cd_values[0] : Z_DEFAULT_COMPRESSION);
+        } else if (curfilter!=H5Z_FILTER_SHUFFLE) {
+            return;
+        }
+    }
+    shuffle=(nfilters==2);
+
+    hsize_t chunk_dims[2];
+    cparms.getChunk(2, chunk_dims);
+    chunk_nc=chunk_dims[0]; // Data are transposed in the file.
+    chunk_nr=chunk_dims[1];
+
+    elsize=default_type.getSize();
+    nrow=NR;
+    ncol=NC;
+    nthreads=std::max(threads, size_t(1));
+    budget=std::max(limit, chunk_nr*chunk_nc*elsize);
+    target=hdata;
+    active=true;
+#endif
+    return;
+}
+
+bool HDF5_chunk_writer::is_active() const {
+    return active;
+}
+
+/* Queueing all chunks in the block of rows [first_row, last_row) and columns [first_col, last_col).
+ * The block must consist of complete chunks, i.e., be aligned to chunk boundaries or the matrix 
+ * extent, and 'in' should have rows as the fastest-changing dimension. Edge chunks are padded 
+ * to the full chunk size, as the library ignores values beyond the extent of the data set.
+ */
+
+void HDF5_chunk_writer::write_block(size_t first_row, size_t last_row, size_t first_col, size_t last_col, 
+        const char* in, const H5::DataSet& hdata) {
+    if (first_row>=last_row || first_col>=last_col) {
+        return;
+    }
+    if (first_row%chunk_nr!=0 || first_col%chunk_nc!=0 || (last_row%chunk_nr!=0 && last_row!=nrow) 
+            || (last_col%chunk_nc!=0 && last_col!=ncol)) {
+        throw std::runtime_error("block should consist of complete chunks");
+    }
+    if (workers.empty()) {
+        start();
+    }
+
+    const size_t block_nr=last_row - first_row, chunk_bytes=chunk_nr*chunk_nc*elsize;
+    const size_t max_queued=std::max(budget/chunk_bytes, size_t(1));
+    for (size_t cc=first_col/chunk_nc; cc*chunk_nc < last_col; ++cc) {
+        const size_t col_start=cc*chunk_nc, col_end=std::min(col_start + chunk_nc, last_col);
+
+        for (size_t cr=first_row/chunk_nr; cr*chunk_nr < last_row; ++cr) {
+            const size_t row_start=cr*chunk_nr, nbytes=(std::min(row_start + chunk_nr, last_row) - row_start)*elsize;
+            auto current=std::make_shared<task>();
+            current->chunk_row=cr;
+            current->chunk_col=cc;
+            current->done=false;
+            current->data.resize(chunk_bytes);
+
+            for (size_t c=col_start; c<col_end; ++c) {
+                const char* src=in + ((c - first_col)*block_nr + row_start - first_row)*elsize;
+                std::copy(src, src + nbytes, current->data.data() + (c - col_start)*chunk_nr*elsize);
+            }
+
+            // Applying back-pressure if too many chunks are queued.
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> lk(lock);
+                    if (queue.size() < max_queued) {
+                        queue.push_back(current);
+                        todo.push_back(current);
+                        break;
+                    }
+                }
+                commit_front(true, hdata);
+            }
+            cv.notify_all();
+        }
+    }
+
+    // Committing whatever has already been compressed, without waiting for the rest.
+    while (commit_front(false, hdata)) {}
+    return;
+}
+
+/* Committing queued chunks until none overlap the requested region. This should be called 
+ * before the region is read or written through the library, to preserve the order of writes.
+ */
+
+void HDF5_chunk_writer::wait(size_t first_row, size_t last_row, size_t first_col, size_t last_col, const H5::DataSet& hdata) {
+    while (true) {
+        bool overlapping=false;
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            for (const auto& current : queue) {
+                if (current->chunk_row*chunk_nr < last_row && (current->chunk_row+1)*chunk_nr > first_row
+                        && current->chunk_col*chunk_nc < last_col && (current->chunk_col+1)*chunk_nc > first_col) {
+                    overlapping=true;
+                    break;
+                }
+            }
+        }
+        if (!overlapping) {
+            break;
+        }
+        commit_front(true, hdata);
+    }
+    return;
+}
+
+void HDF5_chunk_writer::finish(const H5::DataSet& hdata) {
+    while (commit_front(true, hdata)) {}
+    return;
+}
+
+/* Committing the oldest chunk, waiting for its compression if 'block' is true. 
+ * Returns false if there are no chunks, or if the oldest chunk is not yet ready.
+ */
+
+bool HDF5_chunk_writer::commit_front(bool block, const H5::DataSet& hdata) {
+    std::shared_ptr<task> current;
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        if (queue.empty()) {
+            return false;
+        }
+        if (!queue.front()->done) {
+            if (!block) {
+                return false;
+            }
+            cv.wait(lk, [&]() -> bool { return queue.front()->done; });
+        }
+        current=queue.front();
+        queue.pop_front();
+    }
+    commit(current, hdata);
+    return true;
+}
+
+void HDF5_chunk_writer::commit(const std::shared_ptr<task>& current, const H5::DataSet& hdata) {
+    if (current->error) {
+        std::rethrow_exception(current->error);
+    }
+#if H5_VERSION_GE(1, 10, 3)
+    hsize_t offset[2];
+    offset[0]=current->chunk_col*chunk_nc;
+    offset[1]=current->chunk_row*chunk_nr;
+    std::unique_lock<std::mutex> hlock(get_HDF5_mutex(), std::defer_lock);
+    if (locking) {
+        hlock.lock();
+    }
+    if (H5Dwrite_chunk(hdata.getId(), H5P_DEFAULT, 0, offset, current->data.size(), current->data.data()) < 0) {
+        throw std::runtime_error("failed to write raw HDF5 chunk");
+    }
+#endif
+    return;
+}
+
+void HDF5_chunk_writer::start() {
+    for (size_t t=0; t<nthreads; ++t) {
+        workers.push_back(std::thread(&HDF5_chunk_writer::work, this));
+    }
+    return;
+}
+
+/* Stopping the workers, after committing any remaining chunks so that they are not lost if
+ * finish() was not called or failed part-way. This is only a best effort as it cannot throw;
+ * the calling thread should hold the HDF5 lock unless locking was requested.
+ */
+
+void HDF5_chunk_writer::stop() {
+    while (true) {
+        try {
+            if (!commit_front(true, target)) {
+                break;
+            }
+        } catch (...) {
+            // Chunks that failed are discarded, but later chunks are still committed.
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stopping=true;
+    }
+    cv.notify_all();
+    for (auto& w : workers) {
+        w.join();
+    }
+    workers.clear();
+    queue.clear();
+    todo.clear();
+    stopping=false;
+    return;
+}
+
+void HDF5_chunk_writer::work() {
+    std::unique_lock<std::mutex> lk(lock);
+    while (true) {
+        cv.wait(lk, [&]() -> bool { return stopping || !todo.empty(); });
+        if (stopping) {
+            break;
+        }
+        auto current=todo.front();
+        todo.pop_front();
+
+        lk.unlock();
+        try {
+            encode(*current);
+        } catch (...) {
+            current->error=std::current_exception();
+        }
+        lk.lock();
+
+        current->done=true;
+        cv.notify_all();
+    }
+    return;
+}
+
+/* Applying the filters in the same order as the library, i.e., shuffling before deflating. */
+
+void HDF5_chunk_writer::encode(task& current) const {
+    std::vector<char> work;
+    if (shuffle) {
+        work.resize(current.data.size());
+        const size_t nelements=current.data.size()/elsize;
+        char* dest=work.data();
+        for (size_t b=0; b<elsize; ++b) {
+            for (size_t e=0; e<nelements; ++e, ++dest) {
+                *dest=current.data[e*elsize + b];
+            }
+        }
+        current.data.swap(work);
+    }
+
+    uLongf outsize=compressBound(current.data.size());
+    work.resize(outsize);
+    if (compress2(reinterpret_cast<Bytef*>(work.data()), &outsize, 
+                reinterpret_cast<const Bytef*>(current.data.data()), current.data.size(), level)!=Z_OK) {
+        throw std::runtime_error("failed to compress HDF5 chunk");
+    }
+    work.resize(outsize);
+    current.data.swap(work);
+    return;
+}
+
+}
@@ -0,0 +1,140 @@
+#ifndef BEACHMAT_HDF5_CHUNKS_H
+#define BEACHMAT_HDF5_CHUNKS_H
+
+#include "beachmat.h"
+#include "HDF5_utils.h"
+
+namespace beachmat {
+
+/* Process-wide least-recently-used cache of decompressed chunks. Each chunk is keyed by
+ * the file, data set and chunk coordinates, so that clones and separate instances
+ * referring to the same data set can share chunks. Chunks are stored as shared pointers,
+ * such that evicted chunks remain valid for any caller that is still using them.
+ * The key also contains the inode, size and modification time (in nanoseconds) of the file,
+ * but writers in this process should still call invalidate() once they have modified a file,
+ * as a file rewritten in place may not change in any of these respects.
+ */
+
+class HDF5_chunk_cache {
+public:
+    struct key {
+        std::string file, name;
+        long long modified, modified_ns, filesize, inode; // To detect changes to the file.
+        size_t chunk_row, chunk_col;
+        bool operator<(const key&) const;
+    };
+    typedef std::shared_ptr<const std::vector<char> > chunk_ptr;
+
+    chunk_ptr get(const key&);
+    void insert(const key&, chunk_ptr);
+    void invalidate(const std::string&);
+
+    void set_limit(size_t);
+    size_t get_limit() const;
+    size_t get_used() const;
+    void clear();
+
+    static HDF5_chunk_cache& get_global();
+private:
+    HDF5_chunk_cache();
+    void evict();
+
+    size_t limit, used;
+    std::list<key> order;
+    struct entry {
+        chunk_ptr data;
+        std::list<key>::iterator pos;
+    };
+    std::map<key, entry> chunks;
+    mutable std::mutex lock;
+};
+
+/* Engine that reads raw chunks with H5Dread_chunk and decompresses them outside of the
+ * global HDF5 lock. This is only used for data sets where the file type is the same
+ * as the memory type, and where the only filters are deflate and/or shuffle. Chunks
+ * are only stored in the shared cache if caching was requested upon initialization.
+ */
+
+class HDF5_chunk_engine {
+public:
+    HDF5_chunk_engine();
+    void initialize(const std::string&, const std::string&, const H5::DataSet&, const H5::DataType&, size_t, size_t, size_t, bool=true);
+    bool is_active() const;
+    bool is_caching() const;
+    bool uses(const H5::DataType&);
+
+    void extract_row(size_t, size_t, size_t, char*, const H5::DataSet&);
+    void extract_col(size_t, size_t, size_t, char*, const H5::DataSet&);
+    void extract_one(size_t, size_t, char*, const H5::DataSet&);
+    void extract_block(size_t, size_t, size_t, size_t, char*, const H5::DataSet&, size_t);
+private:
+    HDF5_chunk_cache::chunk_ptr get_chunk(size_t, size_t, const H5::DataSet&);
+    HDF5_chunk_cache::chunk_ptr fetch_chunk(const HDF5_chunk_cache::key&, const H5::DataSet&);
+    void read_chunk(size_t, size_t, std::vector<char>&, uint32_t&, const H5::DataSet&);
+
+    bool active, caching;
+    HDF5_chunk_cache::key current;
+    H5::DataType type;
+    hid_t checked_id;
+    bool checked_result;
+    size_t nrow, ncol, elsize, chunk_nr, chunk_nc;
+    std::vector<H5Z_filter_t> filters;
+};
+
+/* Pipelined writer that compresses complete chunks on a pool of worker threads and commits
+ * them with H5Dwrite_chunk in submission order. The producer only copies values into the
+ * queue and never runs zlib itself, blocking only when the queued bytes exceed the budget.
+ * This is only used for data sets where the file type is the same as the memory type, and
+ * where the only filters are deflate (possibly preceded by shuffle). Commits are performed by 
+ * the calling thread, so the worker threads never need the HDF5 lock. By default, all methods 
+ * other than initialize() must be called while holding the lock. If locking is requested upon 
+ * initialization, the lock is instead acquired for each H5Dwrite_chunk call, so that chunk 
+ * assembly and waiting for compression do not block other threads. Copies only take the settings.
+ * Queued chunks are committed to the data set supplied to initialize() when the writer is stopped
+ * (e.g., upon destruction), but errors are only reported by the other methods, e.g., finish().
+ */
+
+class HDF5_chunk_writer {
+public:
+    HDF5_chunk_writer();
+    ~HDF5_chunk_writer();
+
+    HDF5_chunk_writer(const HDF5_chunk_writer&);
+    HDF5_chunk_writer& operator=(const HDF5_chunk_writer&);
+
+    void initialize(const H5::DataSet&, const H5::DataType&, size_t, size_t, size_t, size_t, bool=false);
+    bool is_active() const;
+
+    void write_block(size_t, size_t, size_t, size_t, const char*, const H5::DataSet&);
+    void wait(size_t, size_t, size_t, size_t, const H5::DataSet&);
+    void finish(const H5::DataSet&);
+private:
+    struct task {
+        size_t chunk_row, chunk_col;
+        std::vector<char> data;
+        bool done;
+        std::exception_ptr error;
+    };
+
+    bool active, shuffle, locking;
+    int level;
+    size_t nrow, ncol, elsize, chunk_nr, chunk_nc, nthreads, budget;
+
+    H5::DataSet target;
+    std::deque<std::shared_ptr<task> > queue, todo;
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable cv;
+    bool stopping;
+
+    void start();
+    void stop();
+    void work();
+    void encode(task&) const;
+    void commit(const std::shared_ptr<task>&, const H5::DataSet&);
+    bool commit_front(bool, const H5::DataSet&);
+};
+
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include "beachmat.h"
 #include "any_matrix.h"
 #include "HDF5_utils.h"
+#include "HDF5_chunks.h"
+#include "input_param.h"
 
 namespace beachmat {
 
@@ -12,7 +14,8 @@ namespace beachmat {
 template<typename T, int RTYPE>
 class HDF5_matrix : public any_matrix {
 public:
-    HDF5_matrix(const Rcpp::RObject&);
+    HDF5_matrix(const Rcpp::RObject&, size_t=input_param::DEFAULT_CACHE_SIZE, bool=input_param::DEFAULT_PREFETCH, 
+            bool=input_param::DEFAULT_SHARED_CACHE, size_t=input_param::DEFAULT_THREADS);
     ~HDF5_matrix();
 
     void extract_row(size_t, T*, size_t, size_t);
@@ -22,11 +25,25 @@ public:
     void extract_col(size_t, T*, size_t, size_t);
     template<typename X>
     void extract_col(size_t, X*, const H5::DataType&, size_t, size_t);
+
+    void extract_cols(size_t, size_t, T*, size_t, size_t);
+    template<typename X>
+    void extract_cols(size_t, size_t, X*, const H5::DataType&, size_t, size_t);
     
+    void extract_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, T*);
+    template<typename X>
+    void extract_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, X*, const H5::DataType&);
+
+    void extract_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, T*);
+    template<typename X>
+    void extract_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, X*, const H5::DataType&);
+
     void extract_one(size_t, size_t, T*); // Use of pointer is a bit circuitous, but necessary for character access.
     template<typename X>
     void extract_one(size_t, size_t, X*, const H5::DataType&);  
 
+    const T* get_mapped_col(size_t, size_t, size_t);
+
     const H5::DataType& get_datatype() const;
 
     Rcpp::RObject yield() const;
@@ -35,24 +52,40 @@ protected:
     Rcpp::RObject original;
     std::string filename, dataname;
 
+    // See HDF5_lock_open in HDF5_utils.h; prefetchers are declared after the closing marker.
+    HDF5_lock_open lock_open;
     H5::H5File hfile;
     H5::DataSet hdata;
-    H5::DataSpace hspace, rowspace, colspace, onespace;
-    hsize_t h5_start[2], col_count[2], row_count[2], one_count[2];
+    H5::DataSpace hspace, rowspace, colspace, colsspace, subspace, onespace;
+    hsize_t h5_start[2], col_count[2], row_count[2], one_count[2], cols_count[2];
+
+    H5::DataType default_type, stored_type;
 
-    H5::DataType default_type;
+    // Data in narrow types are read without conversion, and then widened if values of the memory type are requested.
+    storage_type storage;
+    size_t stored_size;
+    std::vector<char> narrow_work;
+    template<typename X>
+    bool widens() const;
+    char* get_narrow_workspace(size_t);
 
-    bool onrow, oncol;
     bool rowokay, colokay;
-    bool largerrow, largercol;
-    H5::FileAccPropList rowlist, collist;
+    HDF5_block_buffer rowblock, colblock;
+    HDF5_chunk_engine engine;
+    size_t nthreads;
+    HDF5_mapped_data mapped;
+    HDF5_lock_close lock_close;
+
+    // Declared last, so that the prefetching threads are stopped before anything else is destroyed.
+    bool prefetching;
+    HDF5_prefetcher rowfetch, colfetch;
 };
 
 /*** Constructor definition ***/
 
 template<typename T, int RTYPE>
-HDF5_matrix<T, RTYPE>::HDF5_matrix(const Rcpp::RObject& incoming) : original(incoming),
-        rowlist(H5::FileAccPropList::DEFAULT.getId()), collist(H5::FileAccPropList::DEFAULT.getId()) {
+HDF5_matrix<T, RTYPE>::HDF5_matrix(const Rcpp::RObject& incoming, size_t cache_size, bool prefetch, bool shared_cache, 
+        size_t threads) : original(incoming), nthreads(threads), prefetching(false) {
 
     std::string ctype=get_class(incoming);
     if (!incoming.isS4() || ctype!="HDF5Matrix") {
@@ -94,9 +127,13 @@ HDF5_matrix<T, RTYPE>::HDF5_matrix(const Rcpp::RObject& incoming) : original(inc
     }
     
     // Setting up the HDF5 accessors.
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
     hfile.openFile(filename.c_str(), H5F_ACC_RDONLY);
     hdata = hfile.openDataSet(dataname.c_str());
     default_type=set_HDF5_data_type(RTYPE, hdata);
+    storage=find_HDF5_storage_type(RTYPE, hdata);
+    stored_type=set_HDF5_storage_type(RTYPE, storage, default_type);
+    stored_size=stored_type.getSize();
 
     hspace = hdata.getSpace();
     if (hspace.getSimpleExtentNdims()!=2) {
@@ -114,9 +151,41 @@ HDF5_matrix<T, RTYPE>::HDF5_matrix(const Rcpp::RObject& incoming) : original(inc
             h5_start, col_count, row_count, 
             one_count, onespace);
 
-    // Setting the chunk cache parameters.
-    calc_HDF5_chunk_cache_settings(this->nrow, this->ncol, hdata.getCreatePlist(), default_type, 
-            onrow, oncol, rowokay, colokay, largerrow, largercol, rowlist, collist);
+    // Setting the chunk cache parameters, and reopening the data set with the new cache.
+    if (cache_size==input_param::DEFAULT_CACHE_SIZE) {
+        cache_size=get_default_cache_size();
+    }
+    const H5::DSetCreatPropList cparms=hdata.getCreatePlist();
+    H5::DSetAccPropList cachelist;
+    calc_HDF5_chunk_cache_settings(this->nrow, this->ncol, cparms, stored_type, 
+            cache_size, rowokay, colokay, cachelist);
+    hdata.close();
+    hdata = hfile.openDataSet(dataname.c_str(), cachelist);
+
+    // Falling back to strip-mined reads if all chunks in a row or column do not fit in the cache.
+    if (!rowokay || !colokay) {
+        hsize_t chunk_dims[2];
+        cparms.getChunk(2, chunk_dims);
+        rowblock=HDF5_block_buffer(true, cache_size, chunk_dims[1], NR);
+        colblock=HDF5_block_buffer(false, cache_size, chunk_dims[0], NC);
+    }
+
+    // Setting up prefetching, which is only useful for chunked data that need decompression.
+    if (prefetch && cparms.getLayout()==H5D_CHUNKED) {
+        hsize_t chunk_dims[2];
+        cparms.getChunk(2, chunk_dims);
+        prefetching=true;
+        rowfetch=HDF5_prefetcher(true, cache_size, chunk_dims[1], NR, NC);
+        colfetch=HDF5_prefetcher(false, cache_size, chunk_dims[0], NC, NR);
+    }
+
+    // Mapping contiguous data sets directly into memory, if possible.
+    mapped.initialize(filename, hfile, hdata, stored_type, NR, NC);
+
+    // Setting up direct chunk access with the shared cache and/or parallel block reads, if possible.
+    if (shared_cache || nthreads > 1) {
+        engine.initialize(filename, dataname, hdata, stored_type, NR, NC, get_default_cache_size(), shared_cache);
+    }
     return;
 }
 
@@ -125,13 +194,49 @@ HDF5_matrix<T, RTYPE>::~HDF5_matrix() {}
 
 /*** Getter functions ***/
 
+template<typename T, int RTYPE>
+template<typename X>
+bool HDF5_matrix<T, RTYPE>::widens() const {
+    return storage!=DEFAULT_STORAGE && std::is_same<X, T>::value;
+}
+
+template<typename T, int RTYPE>
+char* HDF5_matrix<T, RTYPE>::get_narrow_workspace(size_t n) {
+    n*=stored_size;
+    if (narrow_work.size() < n) {
+        narrow_work.resize(n);
+    }
+    return narrow_work.data();
+}
+
 template<typename T, int RTYPE>
 template<typename X>
 void HDF5_matrix<T, RTYPE>::extract_row(size_t r, X* out, const H5::DataType& HDT, size_t first, size_t last) { 
     check_rowargs(r, first, last);
-    reopen_HDF5_file_by_dim(filename, dataname, 
-            hfile, hdata, H5F_ACC_RDONLY, rowlist, 
-            onrow, oncol, largercol, rowokay);
+    if (widens<X>()) {
+        char* work=get_narrow_workspace(last - first);
+        extract_row(r, work, stored_type, first, last);
+        widen_HDF5_values(storage, work, last - first, out);
+        return;
+    }
+    if (mapped.is_active() && mapped.uses(HDT)) {
+        mapped.extract_row(r, first, last, reinterpret_cast<char*>(out));
+        return;
+    }
+    if (prefetching) {
+        rowfetch.extract(r, first, last, reinterpret_cast<char*>(out), HDT, hdata);
+        return;
+    }
+    if (engine.is_caching() && engine.uses(HDT)) {
+        engine.extract_row(r, first, last, reinterpret_cast<char*>(out), hdata);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    if (!rowokay) {
+        rowblock.extract(r, first, last, reinterpret_cast<char*>(out), HDT, hdata, hspace);
+        return;
+    }
     HDF5_select_row(r, first, last, row_count, h5_start, rowspace, hspace);
     hdata.read(out, HDT, rowspace, hspace);
     return;
@@ -147,9 +252,30 @@ template<typename T, int RTYPE>
 template<typename X>
 void HDF5_matrix<T, RTYPE>::extract_col(size_t c, X* out, const H5::DataType& HDT, size_t first, size_t last) { 
     check_colargs(c, first, last);
-    reopen_HDF5_file_by_dim(filename, dataname, 
-            hfile, hdata, H5F_ACC_RDONLY, collist, 
-            oncol, onrow, largerrow, colokay);
+    if (widens<X>()) {
+        char* work=get_narrow_workspace(last - first);
+        extract_col(c, work, stored_type, first, last);
+        widen_HDF5_values(storage, work, last - first, out);
+        return;
+    }
+    if (mapped.is_active() && mapped.uses(HDT)) {
+        mapped.extract_col(c, first, last, reinterpret_cast<char*>(out));
+        return;
+    }
+    if (prefetching) {
+        colfetch.extract(c, first, last, reinterpret_cast<char*>(out), HDT, hdata);
+        return;
+    }
+    if (engine.is_caching() && engine.uses(HDT)) {
+        engine.extract_col(c, first, last, reinterpret_cast<char*>(out), hdata);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    if (!colokay) {
+        colblock.extract(c, first, last, reinterpret_cast<char*>(out), HDT, hdata, hspace);
+        return;
+    }
     HDF5_select_col(c, first, last, col_count, h5_start, colspace, hspace);
     hdata.read(out, HDT, colspace, hspace);
     return;
@@ -161,10 +287,115 @@ void HDF5_matrix<T, RTYPE>::extract_col(size_t c, T* out, size_t first, size_t l
     return;
 }
 
+template<typename T, int RTYPE>
+template<typename X>
+void HDF5_matrix<T, RTYPE>::extract_cols(size_t first_col, size_t last_col, X* out, const H5::DataType& HDT, size_t first, size_t last) { 
+    check_colsargs(first_col, last_col, first, last);
+    if (first_col==last_col || first==last) { 
+        return; // Avoid zero-sized hyperslabs.
+    }
+    if (widens<X>()) {
+        const size_t n=(last_col - first_col)*(last - first);
+        char* work=get_narrow_workspace(n);
+        extract_cols(first_col, last_col, work, stored_type, first, last);
+        widen_HDF5_values(storage, work, n, out);
+        return;
+    }
+    if (mapped.is_active() && mapped.uses(HDT)) {
+        mapped.extract_cols(first_col, last_col, first, last, reinterpret_cast<char*>(out));
+        return;
+    }
+    if (nthreads > 1 && engine.is_active() && engine.uses(HDT)) {
+        engine.extract_block(first, last, first_col, last_col, reinterpret_cast<char*>(out), hdata, nthreads);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    HDF5_select_cols(first_col, last_col, first, last, cols_count, h5_start, colsspace, hspace);
+    hdata.read(out, HDT, colsspace, hspace);
+    return;
+}
+    
+template<typename T, int RTYPE>
+void HDF5_matrix<T, RTYPE>::extract_cols(size_t first_col, size_t last_col, T* out, size_t first, size_t last) { 
+    extract_cols(first_col, last_col, out, default_type, first, last);
+    return;
+}
+
+template<typename T, int RTYPE>
+template<typename X>
+void HDF5_matrix<T, RTYPE>::extract_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, X* out, const H5::DataType& HDT) { 
+    check_rowsubset(r, cols, n);
+    if (n==0) { 
+        return;
+    }
+    if (widens<X>()) {
+        char* work=get_narrow_workspace(n);
+        extract_row_subset(r, cols, n, work, stored_type);
+        widen_HDF5_values(storage, work, n, out);
+        return;
+    }
+    if (mapped.is_active() && mapped.uses(HDT)) {
+        mapped.extract_row_subset(r, cols, n, reinterpret_cast<char*>(out));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    HDF5_select_row_subset(r, cols, n, subspace, hspace);
+    hdata.read(out, HDT, subspace, hspace);
+    return;
+}
+
+template<typename T, int RTYPE>
+void HDF5_matrix<T, RTYPE>::extract_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, T* out) { 
+    extract_row_subset(r, cols, n, out, default_type);
+    return;
+}
+
+template<typename T, int RTYPE>
+template<typename X>
+void HDF5_matrix<T, RTYPE>::extract_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, X* out, const H5::DataType& HDT) { 
+    check_colsubset(c, rows, n);
+    if (n==0) { 
+        return;
+    }
+    if (widens<X>()) {
+        char* work=get_narrow_workspace(n);
+        extract_col_subset(c, rows, n, work, stored_type);
+        widen_HDF5_values(storage, work, n, out);
+        return;
+    }
+    if (mapped.is_active() && mapped.uses(HDT)) {
+        mapped.extract_col_subset(c, rows, n, reinterpret_cast<char*>(out));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    HDF5_select_col_subset(c, rows, n, subspace, hspace);
+    hdata.read(out, HDT, subspace, hspace);
+    return;
+}
+
+template<typename T, int RTYPE>
+void HDF5_matrix<T, RTYPE>::extract_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, T* out) { 
+    extract_col_subset(c, rows, n, out, default_type);
+    return;
+}
+
 template<typename T, int RTYPE>
 template<typename X>
 void HDF5_matrix<T, RTYPE>::extract_one(size_t r, size_t c, X* out, const H5::DataType& HDT) { 
     check_oneargs(r, c);
+    if (mapped.is_active() && mapped.uses(HDT)) {
+        mapped.extract_one(r, c, reinterpret_cast<char*>(out));
+        return;
+    }
+    if (engine.is_caching() && engine.uses(HDT)) {
+        engine.extract_one(r, c, reinterpret_cast<char*>(out), hdata);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
     HDF5_select_one(r, c, one_count, h5_start, hspace);
     hdata.read(out, HDT, onespace, hspace);
     return;
@@ -176,6 +407,19 @@ void HDF5_matrix<T, RTYPE>::extract_one(size_t r, size_t c, T* out) {
     return;
 }
 
+/* Returns a pointer to the mapped values of column 'c' starting from row 'first',
+ * or NULL if the data set is not memory-mapped.
+ */
+
+template<typename T, int RTYPE>
+const T* HDF5_matrix<T, RTYPE>::get_mapped_col(size_t c, size_t first, size_t last) {
+    check_colargs(c, first, last);
+    if (!mapped.is_active() || !mapped.uses(default_type)) {
+        return NULL;
+    }
+    return reinterpret_cast<const T*>(mapped.get_col(c, first));
+}
+
 template<typename T, int RTYPE>
 const H5::DataType& HDF5_matrix<T, RTYPE>::get_datatype() const { 
     return default_type;
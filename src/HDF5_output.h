@@ -4,6 +4,7 @@
 #include "beachmat.h"
 #include "any_matrix.h"
 #include "HDF5_utils.h"
+#include "HDF5_chunks.h"
 #include "output_param.h"
 
 namespace beachmat {
@@ -17,7 +18,10 @@ public:
             size_t=output_param::DEFAULT_CHUNKDIM, 
             size_t=output_param::DEFAULT_CHUNKDIM, 
             int=output_param::DEFAULT_COMPRESS, 
-            size_t=output_param::DEFAULT_STRLEN);
+            size_t=output_param::DEFAULT_STRLEN,
+            size_t=output_param::DEFAULT_CACHE_SIZE,
+            size_t=output_param::DEFAULT_THREADS,
+            storage_type=output_param::DEFAULT_STORAGE_TYPE);
     ~HDF5_output();
     
     void insert_row(size_t, const T*, size_t, size_t);
@@ -40,38 +44,52 @@ public:
 
     void extract_one(size_t, size_t, T*);
 
+    // Must be called (directly or via yield()) to detect write errors, as the destructor cannot report them.
+    void flush();
+
     Rcpp::RObject yield();
 
     matrix_type get_matrix_type() const;
 protected:
     std::string fname, dname;
 
+    // See HDF5_lock_open in HDF5_utils.h; this also covers the release of the shared write buffer.
+    HDF5_lock_open lock_open;
     H5::H5File hfile;
     H5::DataSet hdata;
     H5::DataSpace hspace, rowspace, colspace, onespace;
     hsize_t h5_start[2], col_count[2], row_count[2], one_count[2], zero_start[1];
 
-    H5::DataType default_type;
+    H5::DataType default_type, file_type;
+    std::shared_ptr<HDF5_write_buffer> writebuf; // shared with clones, so that pending values are seen by all of them.
+    HDF5_lock_close lock_close;
+
+    /* Values must be checked before they are narrowed, as HDF5 would otherwise silently clip them.
+     * Missing values are also rejected for single-precision storage, as NA would be converted into NaN.
+     */
+    bool limited, single;
+    int lower, upper;
+    template<typename X>
+    void check_storage_range(const X*, size_t) const;
+
     void select_row(size_t, size_t, size_t);
     void select_col(size_t, size_t, size_t);
     void select_one(size_t, size_t);
 
     T get_empty() const;
     Rcpp::RObject get_firstval();
-
-    bool onrow, oncol;
-    bool rowokay, colokay;
-    bool largerrow, largercol;
-    H5::FileAccPropList rowlist, collist;
 };
 
 /*** Constructor definition ***/
 
 template<typename T, int RTYPE>
-HDF5_output<T, RTYPE>::HDF5_output (size_t nr, size_t nc, size_t chunk_nr, size_t chunk_nc, int compress, size_t len) : any_matrix(nr, nc), 
-        rowlist(H5::FileAccPropList::DEFAULT.getId()), collist(H5::FileAccPropList::DEFAULT.getId()) {
+HDF5_output<T, RTYPE>::HDF5_output (size_t nr, size_t nc, size_t chunk_nr, size_t chunk_nc, int compress, size_t len, size_t cache_size, 
+        size_t threads, storage_type storage) : any_matrix(nr, nc), limited(false), single(false), lower(0), upper(0) {
 
-    // Pulling out settings.
+    /* Pulling out settings. The lock is held as the R function creates the file with rhdf5, 
+     * while a prefetching thread may be reading from another data set at the same time.
+     */
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
     const Rcpp::Environment env=Rcpp::Environment::namespace_env("beachmat");
     Rcpp::Function fun=env["setupHDF5Array"];
     Rcpp::List collected=fun(Rcpp::IntegerVector::create(this->nrow, this->ncol), Rcpp::StringVector(translate_type(RTYPE)),
@@ -97,6 +115,12 @@ HDF5_output<T, RTYPE>::HDF5_output (size_t nr, size_t nc, size_t chunk_nr, size_
     // Opening the file, setting the type and creating the data set.
     hfile.openFile(fname, H5F_ACC_RDWR);
     default_type=set_HDF5_data_type(RTYPE, len);
+
+    // Storing values in a narrower type in the file, if requested.
+    file_type=set_HDF5_storage_type(RTYPE, storage, default_type);
+    limited=get_storage_limits(storage, lower, upper);
+    single=(storage==FLOAT_STORAGE);
+
     H5::DSetCreatPropList plist;
     const T empty=get_empty();
     plist.setFillValue(default_type, &empty);
@@ -118,7 +142,28 @@ HDF5_output<T, RTYPE>::HDF5_output (size_t nr, size_t nc, size_t chunk_nr, size_
     dims[1]=this->nrow; 
 
     hspace.setExtentSimple(2, dims.data());
-    hdata=hfile.createDataSet(dname, default_type, hspace, plist); 
+
+    /* Setting the chunk cache parameters. If all chunks in a row or column do not fit 
+     * in the cache, writes will still work but chunks may be flushed and reloaded.
+     */
+    if (cache_size==output_param::DEFAULT_CACHE_SIZE) {
+        cache_size=get_default_cache_size();
+    }
+    bool rowokay, colokay;
+    H5::DSetAccPropList cachelist;
+    calc_HDF5_chunk_cache_settings(this->nrow, this->ncol, plist, file_type, 
+            cache_size, rowokay, colokay, cachelist);
+    hdata=hfile.createDataSet(dname, file_type, hspace, plist, cachelist); 
+
+    /* Accumulating values in a write-back buffer for chunked data, to avoid rewriting partial chunks.
+     * Completed blocks are compressed in parallel if multiple threads are requested.
+     */
+    if (compress>0) {
+        writebuf=std::make_shared<HDF5_write_buffer>(this->nrow, this->ncol, chunk_nr, chunk_nc, file_type, cache_size, storage);
+        writebuf->set_pipeline(hdata, threads);
+    } else {
+        writebuf=std::make_shared<HDF5_write_buffer>();
+    }
 
     // Initializing the hsize_t[2] arrays.
     initialize_HDF5_size_arrays (this->nrow, this->ncol, 
@@ -132,24 +177,45 @@ HDF5_output<T, RTYPE>::HDF5_output (size_t nr, size_t nc, size_t chunk_nr, size_
         H5::Attribute att = hdata.createAttribute("storage.mode", str_type, att_space);
         att.write(str_type, std::string("logical"));
     }
-
-    // Setting the chunk cache parameters.
-    calc_HDF5_chunk_cache_settings(this->nrow, this->ncol, hdata.getCreatePlist(), default_type, 
-            onrow, oncol, rowokay, colokay, largerrow, largercol, rowlist, collist);
     return;
 }
 
 template<typename T, int RTYPE>
-HDF5_output<T, RTYPE>::~HDF5_output() {}
+HDF5_output<T, RTYPE>::~HDF5_output() {
+    try {
+        flush();
+    } catch (...) {
+        // Destructors should not throw; call flush() explicitly to detect errors.
+    }
+}
 
 /*** Setter methods ***/
 
+template<typename T, int RTYPE>
+template<typename X>
+void HDF5_output<T, RTYPE>::check_storage_range(const X* in, size_t n) const {
+    if (single && std::is_same<X, double>::value) {
+        for (size_t i=0; i<n; ++i) {
+            if (R_IsNA(in[i])) {
+                throw std::runtime_error("NA values cannot be stored in single precision");
+            }
+        }
+        return;
+    }
+    if (!limited) {
+        return;
+    }
+    for (size_t i=0; i<n; ++i) {
+        if (!(in[i] >= lower && in[i] <= upper)) { // also catches NaNs.
+            throw std::runtime_error("values are out of range for the integer storage type");
+        }
+    }
+    return;
+}
+
 template<typename T, int RTYPE>
 void HDF5_output<T, RTYPE>::select_col(size_t c, size_t first, size_t last) {
     check_colargs(c, first, last);
-    reopen_HDF5_file_by_dim(fname, dname,
-            hfile, hdata, H5F_ACC_RDWR, collist, 
-            oncol, onrow, largerrow, colokay);
     HDF5_select_col(c, first, last, col_count, h5_start, colspace, hspace);
     return;
 }
@@ -157,6 +223,12 @@ void HDF5_output<T, RTYPE>::select_col(size_t c, size_t first, size_t last) {
 template<typename T, int RTYPE>
 template<typename X>
 void HDF5_output<T, RTYPE>::insert_col(size_t c, const X* in, const H5::DataType& HDT, size_t first, size_t last) {
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    check_colargs(c, first, last);
+    check_storage_range(in, last - first);
+    if (writebuf->insert(false, c, first, last, reinterpret_cast<const char*>(in), HDT, hdata)) {
+        return;
+    }
     select_col(c, first, last);
     hdata.write(in, HDT, colspace, hspace);
     return;
@@ -171,17 +243,20 @@ void HDF5_output<T, RTYPE>::insert_col(size_t c, const T* in, size_t first, size
 template<typename T, int RTYPE>
 void HDF5_output<T, RTYPE>::select_row(size_t r, size_t first, size_t last) {
     check_rowargs(r, first, last);
-    reopen_HDF5_file_by_dim(fname, dname, 
-            hfile, hdata, H5F_ACC_RDWR, rowlist, 
-            onrow, oncol, largercol, rowokay);
     HDF5_select_row(r, first, last, row_count, h5_start, rowspace, hspace);
     return;
 }
 
 template<typename T, int RTYPE>
 template<typename X>
-void HDF5_output<T, RTYPE>::insert_row(size_t c, const X* in, const H5::DataType& HDT, size_t first, size_t last) {
-    select_row(c, first, last);
+void HDF5_output<T, RTYPE>::insert_row(size_t r, const X* in, const H5::DataType& HDT, size_t first, size_t last) {
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    check_rowargs(r, first, last);
+    check_storage_range(in, last - first);
+    if (writebuf->insert(true, r, first, last, reinterpret_cast<const char*>(in), HDT, hdata)) {
+        return;
+    }
+    select_row(r, first, last);
     hdata.write(in, HDT, rowspace, hspace);
     return;
 }
@@ -201,6 +276,12 @@ void HDF5_output<T, RTYPE>::select_one(size_t r, size_t c) {
 
 template<typename T, int RTYPE>
 void HDF5_output<T, RTYPE>::insert_one(size_t r, size_t c, T* in) {
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    check_oneargs(r, c);
+    check_storage_range(in, 1);
+    if (writebuf->insert_one(r, c, reinterpret_cast<const char*>(in), default_type, hdata)) {
+        return;
+    }
     select_one(r, c);
     hdata.write(in, default_type, onespace, hspace);
     return;
@@ -211,6 +292,11 @@ void HDF5_output<T, RTYPE>::insert_one(size_t r, size_t c, T* in) {
 template<typename T, int RTYPE>
 template<typename X>
 void HDF5_output<T, RTYPE>::extract_row(size_t r, X* out, const H5::DataType& HDT, size_t first, size_t last) { 
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    check_rowargs(r, first, last);
+    if (writebuf->extract(true, r, first, last, reinterpret_cast<char*>(out), HDT, hdata)) {
+        return;
+    }
     select_row(r, first, last);
     hdata.read(out, HDT, rowspace, hspace);
     return;
@@ -225,6 +311,11 @@ void HDF5_output<T, RTYPE>::extract_row(size_t r, T* out, size_t first, size_t l
 template<typename T, int RTYPE>
 template<typename X>
 void HDF5_output<T, RTYPE>::extract_col(size_t c, X* out, const H5::DataType& HDT, size_t first, size_t last) { 
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    check_colargs(c, first, last);
+    if (writebuf->extract(false, c, first, last, reinterpret_cast<char*>(out), HDT, hdata)) {
+        return;
+    }
     select_col(c, first, last);
     hdata.read(out, HDT, colspace, hspace);
     return;
@@ -238,11 +329,26 @@ void HDF5_output<T, RTYPE>::extract_col(size_t c, T* out, size_t first, size_t l
 
 template<typename T, int RTYPE>
 void HDF5_output<T, RTYPE>::extract_one(size_t r, size_t c, T* out) { 
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    check_oneargs(r, c);
+    if (writebuf->extract_one(r, c, reinterpret_cast<char*>(out), default_type, hdata)) {
+        return;
+    }
     select_one(r, c);
     hdata.read(out, default_type, onespace, hspace);
     return;
 }
 
+/*** Flushing buffered values ***/
+
+template<typename T, int RTYPE>
+void HDF5_output<T, RTYPE>::flush() {
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+    writebuf->flush(hdata);
+    HDF5_chunk_cache::get_global().invalidate(fname); // Chunks from a previous version of the file may be cached.
+    return;
+}
+
 // get_empty() defined for each realized class separately.
 
 // get_firstval() defined for each realized class separately.
@@ -251,6 +357,7 @@ void HDF5_output<T, RTYPE>::extract_one(size_t r, size_t c, T* out) {
 
 template<typename T, int RTYPE>
 Rcpp::RObject HDF5_output<T, RTYPE>::yield() {
+    flush();
     std::string seedclass="HDF5ArraySeed";
     Rcpp::S4 h5seed(seedclass);
 
@@ -1,4 +1,13 @@
 #include "HDF5_utils.h"
+#include "HDF5_chunks.h"
+#include <limits>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace beachmat {
 
@@ -8,28 +17,55 @@ namespace beachmat {
 
 /* HDF5 utilities. */
 
-size_t get_cache_size_hard_limit () {
+// Clamping before the conversion, as values that cannot be represented by size_t are undefined.
+static size_t to_cache_size(double val) {
+    if (val >= static_cast<double>(std::numeric_limits<size_t>::max())) {
+        return std::numeric_limits<size_t>::max();
+    }
+    return val;
+}
+
+size_t get_default_cache_size () {
+    // Checking the R option first, then the environment variable, before falling back to the default.
+    Rcpp::RObject option=Rf_GetOption1(Rf_install("beachmat.cache.size"));
+    if (!option.isNULL()) {
+        if ((option.sexp_type()!=REALSXP && option.sexp_type()!=INTSXP) || Rf_length(option.get__())!=1) {
+            throw std::runtime_error("'beachmat.cache.size' option should be a numeric scalar");
+        }
+        const double val=Rf_asReal(option.get__());
+        if (!(val > 0) || !std::isfinite(val)) {
+            throw std::runtime_error("'beachmat.cache.size' option should be a finite positive number");
+        }
+        return to_cache_size(val);
+    }
+
+    const char* env=std::getenv("BEACHMAT_CACHE_SIZE");
+    if (env!=NULL && env[0]!='\0') {
+        char* end;
+        const double val=std::strtod(env, &end);
+        if (*end!='\0' || !(val > 0) || !std::isfinite(val)) {
+            throw std::runtime_error("'BEACHMAT_CACHE_SIZE' should be a finite positive number");
+        }
+        return to_cache_size(val);
+    }
+
     return 2000000000;
 }
 
-/* This function computes the chunk cache settings for a HDF5 file
- * of a given dimension. It takes a bunch of HDF5_matrix/output 
- * members and modifies them by reference.
+/* This function computes the chunk cache settings for a HDF5 data set
+ * of a given dimension, given a budget for the cache size. It sets flags 
+ * indicating whether all chunks in a row or column can fit in the cache, 
+ * and fills in the dataset access property list used to open the data set.
  */
 
 void calc_HDF5_chunk_cache_settings (const size_t total_nrows, const size_t total_ncols, 
         const H5::DSetCreatPropList& cparms, const H5::DataType& default_type,
-        bool& onrow, bool& oncol, bool& rowokay, bool& colokay, bool& largerrow, bool& largercol,
-        H5::FileAccPropList& rowlist, H5::FileAccPropList& collist) {
+        const size_t cache_size, bool& rowokay, bool& colokay, H5::DSetAccPropList& cachelist) {
 
     if (cparms.getLayout()!=H5D_CHUNKED) {
-        // If contiguous, setting the flags to avoid reopening the file.
-        onrow=true;
-        oncol=true;
-        rowokay=false;
-        colokay=false;
-        largerrow=false;
-        largercol=false;
+        // If contiguous, there is no chunk cache to worry about.
+        rowokay=true;
+        colokay=true;
         return;
     }
     
@@ -51,49 +87,747 @@ void calc_HDF5_chunk_cache_settings (const size_t total_nrows, const size_t tota
      * The approach used below avoids overflow from computing eachchunk*num_Xchunks.
      */
     const size_t eachchunk=default_type.getSize() * chunk_nrows * chunk_ncols;
-    const size_t nchunks_in_cache=get_cache_size_hard_limit()/eachchunk;
+    const size_t nchunks_in_cache=cache_size/eachchunk;
     rowokay=nchunks_in_cache >= num_chunks_per_row; 
     colokay=nchunks_in_cache >= num_chunks_per_col; 
 
-    const size_t eachrow=eachchunk * num_chunks_per_row; 
-    const size_t eachcol=eachchunk * num_chunks_per_col;
-    largercol=eachcol >= eachrow;
-    largerrow=eachrow >= eachcol;
-
-    /* The first argument is ignored, according to https://support.hdfgroup.org/HDF5/doc/RM/RM_H5P.html.
-     * Setting w0 to 0 to evict the last used chunk; no need to worry about full vs partial reads here.
+    /* A single cache is used for both row and column access, as HDF5 shares the cache 
+     * across all handles to the same data set. This is sized to hold all chunks along 
+     * the larger dimension (within the limit), so switching between row and column 
+     * access does not require reopening the file or discarding the cached chunks.
+     * Memory is only allocated as chunks are read, so the smaller dimension is not penalized.
      */
-    rowlist.setCache(10000, nslots, eachrow, 0);
-    collist.setCache(10000, nslots, eachcol, 0);
+    size_t cachesize=0;
+    if (rowokay) { 
+        cachesize=eachchunk * num_chunks_per_row;
+    }
+    if (colokay) {
+        cachesize=std::max(cachesize, eachchunk * num_chunks_per_col);
+    }
+
+    // Setting w0 to 0 to evict the last used chunk; no need to worry about full vs partial reads here.
+    cachelist.setChunkCache(nslots, cachesize, 0);
+    return;
+}
+
+/* Methods for the block buffer. The block size is chosen to fit within the budget,
+ * and is aligned to the chunk boundaries so that no chunk is read in two partial blocks
+ * more often than necessary. Blocks are refilled when the requested row (or column), 
+ * the slice or the memory data type changes.
+ */
+
+HDF5_block_buffer::HDF5_block_buffer() : HDF5_block_buffer(true, 0, 1, 0) {}
+
+HDF5_block_buffer::HDF5_block_buffer(bool br, size_t b, size_t ce, size_t te) : byrow(br), budget(b), 
+        chunk_extent(std::max(ce, size_t(1))), total_extent(te), 
+        filled(false), block_start(0), block_end(0), block_first(0), block_last(0) {}
+
+void HDF5_block_buffer::extract(size_t i, size_t first, size_t last, char* out, const H5::DataType& HDT, 
+        const H5::DataSet& hdata, H5::DataSpace& hspace) {
+    const size_t nvals=last-first;
+    if (nvals==0) {
+        return;
+    }
+    const size_t elsize=HDT.getSize();
+
+    if (!filled || i < block_start || i >= block_end || first!=block_first || last!=block_last || !(HDT==block_type)) {
+        const size_t nfit=std::max(budget/(elsize*nvals), size_t(1));
+        const size_t nblock=std::min(nfit, chunk_extent);
+        const size_t chunk_start=(i/chunk_extent)*chunk_extent;
+        block_start=chunk_start + ((i-chunk_start)/nblock)*nblock;
+        block_end=std::min(std::min(block_start + nblock, chunk_start + chunk_extent), total_extent);
+        block_first=first;
+        block_last=last;
+        block_type.copy(HDT);
+
+        // Data are transposed in the file, so rows are the second dimension.
+        const size_t nlines=block_end - block_start;
+        if (byrow) {
+            block_offset[0]=first;
+            block_offset[1]=block_start;
+            block_count[0]=nvals;
+            block_count[1]=nlines;
+        } else {
+            block_offset[0]=block_start;
+            block_offset[1]=first;
+            block_count[0]=nlines;
+            block_count[1]=nvals;
+        }
+        hsize_t total=nlines*nvals;
+        blockspace.setExtentSimple(1, &total);
+        blockspace.selectAll();
+        hspace.selectHyperslab(H5S_SELECT_SET, block_count, block_offset);
+
+        buffer.resize(total*elsize);
+        hdata.read(buffer.data(), HDT, blockspace, hspace);
+        filled=true;
+    }
+
+    const size_t nlines=block_end - block_start;
+    const size_t offset=i - block_start;
+    if (byrow) {
+        // Each row is strided across the columns in the block.
+        const char* src=buffer.data() + offset*elsize;
+        for (size_t v=0; v<nvals; ++v, src+=nlines*elsize, out+=elsize) {
+            std::copy(src, src+elsize, out);
+        }
+    } else {
+        // Each column is contiguous in the block.
+        const char* src=buffer.data() + offset*nvals*elsize;
+        std::copy(src, src + nvals*elsize, out);
+    }
+    return;
+}
+
+/* Global lock for HDF5 library calls. */
+
+std::mutex& get_HDF5_mutex() {
+    static std::mutex hdf5_lock;
+    return hdf5_lock;
+}
+
+HDF5_lock_open::HDF5_lock_open() {
+    get_HDF5_mutex().lock();
+}
+
+HDF5_lock_open::HDF5_lock_open(const HDF5_lock_open&) {
+    get_HDF5_mutex().lock();
+}
+
+HDF5_lock_open::~HDF5_lock_open() {
+    get_HDF5_mutex().unlock();
+}
 
-    // File is not opened on either row or column yet.
-    onrow=false; 
-    oncol=false;
+HDF5_lock_close::HDF5_lock_close() {
+    get_HDF5_mutex().unlock();
+}
+
+HDF5_lock_close::HDF5_lock_close(const HDF5_lock_close&) {
+    get_HDF5_mutex().unlock();
+}
+
+HDF5_lock_close::~HDF5_lock_close() {
+    get_HDF5_mutex().lock();
+}
+
+/* Methods for the prefetcher. Blocks are aligned to chunk boundaries and sized to fit within 
+ * the budget, noting that two blocks are held in memory at any time. The next block is 
+ * requested in the direction of travel, so that both forward and reverse sweeps are supported.
+ * The memory type is tracked by identifier, to avoid HDF5 calls while the thread is reading.
+ */
+
+HDF5_prefetcher::block::block() : valid(false), start(0), end(0) {}
+
+HDF5_prefetcher::HDF5_prefetcher() : HDF5_prefetcher(true, 0, 1, 0, 0) {}
+
+HDF5_prefetcher::HDF5_prefetcher(bool br, size_t b, size_t ce, size_t te, size_t oe) : byrow(br), budget(b), 
+        chunk_extent(std::max(ce, size_t(1))), total_extent(te), other_extent(oe), 
+        block_id(H5I_INVALID_HID), elsize(0), nblock(1), last_index(0), 
+        busy(false), finished(false), source(NULL) {}
+
+HDF5_prefetcher::HDF5_prefetcher(const HDF5_prefetcher& other) : 
+    HDF5_prefetcher(other.byrow, other.budget, other.chunk_extent, other.total_extent, other.other_extent) {}
+
+HDF5_prefetcher& HDF5_prefetcher::operator=(const HDF5_prefetcher& other) {
+    if (this!=&other) {
+        stop();
+        byrow=other.byrow;
+        budget=other.budget;
+        chunk_extent=other.chunk_extent;
+        total_extent=other.total_extent;
+        other_extent=other.other_extent;
+
+        current=block();
+        pending=block();
+        block_id=H5I_INVALID_HID;
+        elsize=0;
+        nblock=1;
+        last_index=0;
+        busy=false;
+        finished=false;
+        source=NULL;
+        error=nullptr;
+    }
+    return *this;
+}
+
+HDF5_prefetcher::~HDF5_prefetcher() {
+    stop();
+    if (block_type) {
+        std::lock_guard<std::mutex> hlock(get_HDF5_mutex());
+        block_type.reset();
+    }
+}
+
+void HDF5_prefetcher::extract(size_t i, size_t first, size_t last, char* out, const H5::DataType& HDT, const H5::DataSet& hdata) {
+    const size_t nvals=last-first;
+    if (nvals==0) {
+        return;
+    }
+
+    if (HDT.getId()!=block_id) {
+        // Discarding all blocks if the memory type changes.
+        wait();
+        current.valid=pending.valid=false;
+        std::lock_guard<std::mutex> hlock(get_HDF5_mutex());
+        block_type.reset(new H5::DataType);
+        block_type->copy(HDT);
+        block_id=HDT.getId();
+        elsize=HDT.getSize();
+        nblock=std::min(chunk_extent, std::max(budget/(elsize*other_extent), size_t(1)));
+    }
+
+    if (!current.valid || i < current.start || i >= current.end) {
+        const bool forward=(!current.valid || i >= last_index);
+        if (!pending.valid || i < pending.start || i >= pending.end) {
+            wait(); // Discarding the pending block, as it is not the one we want.
+            request(i, hdata);
+        }
+        wait();
+        std::swap(current, pending);
+        pending.valid=false;
+
+        if (forward) {
+            if (current.end < total_extent) {
+                request(current.end, hdata);
+            }
+        } else if (current.start > 0) {
+            request(current.start-1, hdata);
+        }
+    }
+    last_index=i;
+
+    const size_t nlines=current.end - current.start;
+    const size_t offset=i - current.start;
+    if (byrow) {
+        // Each row is strided across the columns in the block.
+        const char* src=current.data.data() + (offset + first*nlines)*elsize;
+        for (size_t v=0; v<nvals; ++v, src+=nlines*elsize, out+=elsize) {
+            std::copy(src, src+elsize, out);
+        }
+    } else {
+        // Each column is contiguous in the block.
+        const char* src=current.data.data() + (offset*other_extent + first)*elsize;
+        std::copy(src, src + nvals*elsize, out);
+    }
+    return;
+}
+
+void HDF5_prefetcher::find_block(size_t i, size_t& start, size_t& end) const {
+    const size_t chunk_start=(i/chunk_extent)*chunk_extent;
+    start=chunk_start + ((i-chunk_start)/nblock)*nblock;
+    end=std::min(std::min(start + nblock, chunk_start + chunk_extent), total_extent);
+    return;
+}
+
+void HDF5_prefetcher::request(size_t i, const H5::DataSet& hdata) {
+    find_block(i, pending.start, pending.end);
+    pending.data.resize((pending.end - pending.start)*other_extent*elsize);
+    pending.valid=true;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        source=&hdata;
+        busy=true;
+    }
+    if (!worker.joinable()) {
+        worker=std::thread(&HDF5_prefetcher::run, this);
+    }
+    cv.notify_all();
     return;
 }
 
-/* This function reopens the file with the chunk cache optimized for the
- * specified dimension. It needs a lot of internal components from the 
- * HDF5_matrix and HDF5_output objects to do so, including flags for the
- * other dimension (e.g., 'dim=>col' and 'other=>row' for column access).
+void HDF5_prefetcher::wait() {
+    std::unique_lock<std::mutex> lk(lock);
+    cv.wait(lk, [&] { return !busy; });
+    if (error) {
+        std::exception_ptr err=error;
+        error=nullptr;
+        pending.valid=false;
+        std::rethrow_exception(err);
+    }
+    return;
+}
+
+void HDF5_prefetcher::stop() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            finished=true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+    return;
+}
+
+void HDF5_prefetcher::run() {
+    std::unique_lock<std::mutex> lk(lock);
+    while (true) {
+        cv.wait(lk, [&] { return busy || finished; });
+        if (finished) {
+            break;
+        }
+        lk.unlock();
+
+        // Data are transposed in the file, so rows are the second dimension.
+        std::exception_ptr err;
+        try {
+            const size_t nlines=pending.end - pending.start;
+            hsize_t offset[2], count[2];
+            if (byrow) {
+                offset[0]=0;
+                offset[1]=pending.start;
+                count[0]=other_extent;
+                count[1]=nlines;
+            } else {
+                offset[0]=pending.start;
+                offset[1]=0;
+                count[0]=nlines;
+                count[1]=other_extent;
+            }
+            hsize_t total=nlines*other_extent;
+
+            std::lock_guard<std::mutex> hlock(get_HDF5_mutex());
+            H5::DataSpace memspace(1, &total);
+            H5::DataSpace filespace=source->getSpace();
+            filespace.selectHyperslab(H5S_SELECT_SET, count, offset);
+            source->read(pending.data.data(), *block_type, memspace, filespace);
+        } catch (H5::Exception& e) {
+            err=std::make_exception_ptr(std::runtime_error(e.getDetailMsg()));
+        } catch (...) {
+            err=std::current_exception();
+        }
+
+        lk.lock();
+        error=err;
+        busy=false;
+        cv.notify_all();
+    }
+    return;
+}
+
+/* Methods for the write-back buffer. Each block spans all rows (or columns) of the matrix
+ * and a chunk-aligned range of columns (or rows), and is only used if it fits in the budget.
+ * In memory, each block is stored with rows as the fastest-changing dimension.
+ */
+
+HDF5_write_buffer::HDF5_write_buffer() : nrow(0), ncol(0), chunk_nr(1), chunk_nc(1), budget(0), elsize(0), storage(DEFAULT_STORAGE),
+    checked_id(H5I_INVALID_HID), checked_result(false), pending(false), byrow(false), block_start(0), block_end(0), ncomplete(0) {}
+
+HDF5_write_buffer::HDF5_write_buffer(size_t NR, size_t NC, size_t cnr, size_t cnc, const H5::DataType& default_type, size_t b, 
+        storage_type s) : 
+    nrow(NR), ncol(NC), chunk_nr(std::max(cnr, size_t(1))), chunk_nc(std::max(cnc, size_t(1))), budget(b), 
+    elsize(default_type.getSize()), type(default_type), storage(s), 
+    checked_id(H5I_INVALID_HID), checked_result(false), pending(false), byrow(false), block_start(0), block_end(0), ncomplete(0) {}
+
+/* Setting up a pipeline with the specified number of compression threads. This has no effect
+ * if the data set is not suitable for direct chunk writes, or if only one thread is requested.
+ */
+
+void HDF5_write_buffer::set_pipeline(const H5::DataSet& hdata, size_t nthreads) {
+    pipeline.reset();
+    if (nthreads > 1) {
+        auto candidate=std::make_shared<HDF5_chunk_writer>();
+        candidate->initialize(hdata, type, nrow, ncol, nthreads, budget);
+        if (candidate->is_active()) {
+            pipeline=candidate;
+        }
+    }
+    return;
+}
+
+bool HDF5_write_buffer::fits(bool br) const {
+    const size_t nbytes=(br ? chunk_nr*ncol : chunk_nc*nrow)*elsize;
+    return nbytes > 0 && nbytes <= budget;
+}
+
+/* Inserting values into row (or column) 'index' from 'first' to 'last'. Returns false if the 
+ * block does not fit in the budget, in which case the insertion should be performed directly
+ * (after flushing any overlapping block, so that the pending values do not overwrite it).
+ */
+
+bool HDF5_write_buffer::insert(bool isrow, size_t index, size_t first, size_t last, 
+        const char* in, const H5::DataType& HDT, H5::DataSet& hdata) {
+    const size_t first_row=(isrow ? index : first), last_row=(isrow ? index+1 : last);
+    const size_t first_col=(isrow ? first : index), last_col=(isrow ? last : index+1);
+    if (!fits(isrow)) {
+        sync(first_row, last_row, first_col, last_col, hdata);
+        return false;
+    }
+    if (!pending || byrow!=isrow || index < block_start || index >= block_end) {
+        load(isrow, index, hdata);
+    }
+
+    const char* src=convert_in(in, last - first, HDT);
+    transfer(first_row, last_row, first_col, last_col, const_cast<char*>(src), true);
+
+    // Flushing if all rows (or columns) in the block have been completely filled.
+    if (first==0 && last==(isrow ? ncol : nrow)) {
+        unsigned char& done=complete[index - block_start];
+        if (!done) {
+            done=1;
+            ++ncomplete;
+            if (ncomplete==block_end - block_start) {
+                write(hdata);
+            }
+        }
+    }
+    return true;
+}
+
+/* Single values are only inserted if they lie in the pending block, to avoid loading 
+ * an entire block for each value when values are set in an arbitrary order.
+ */
+
+bool HDF5_write_buffer::insert_one(size_t r, size_t c, const char* in, const H5::DataType& HDT, H5::DataSet& hdata) {
+    if (!contains(r, r+1, c, c+1)) {
+        sync(r, r+1, c, c+1, hdata);
+        return false;
+    }
+    const char* src=convert_in(in, 1, HDT);
+    transfer(r, r+1, c, c+1, const_cast<char*>(src), true);
+    return true;
+}
+
+/* Extracting values from the pending block, if it contains the requested region.
+ * Otherwise, the block is written if it overlaps the region, and false is returned.
+ */
+
+bool HDF5_write_buffer::extract(bool isrow, size_t index, size_t first, size_t last, 
+        char* out, const H5::DataType& HDT, H5::DataSet& hdata) {
+    const size_t first_row=(isrow ? index : first), last_row=(isrow ? index+1 : last);
+    const size_t first_col=(isrow ? first : index), last_col=(isrow ? last : index+1);
+    if (contains(first_row, last_row, first_col, last_col)) {
+        if (uses(HDT)) {
+            transfer(first_row, last_row, first_col, last_col, out, false);
+        } else {
+            const size_t n=last - first;
+            scratch.resize(n*std::max(elsize, HDT.getSize()));
+            transfer(first_row, last_row, first_col, last_col, scratch.data(), false);
+            convert_out(out, n, HDT);
+        }
+        return true;
+    }
+    sync(first_row, last_row, first_col, last_col, hdata);
+    return false;
+}
+
+bool HDF5_write_buffer::extract_one(size_t r, size_t c, char* out, const H5::DataType& HDT, H5::DataSet& hdata) {
+    return extract(false, c, r, r+1, out, HDT, hdata);
+}
+
+/* Converting between the memory type and the file type. The comparison is cached as it is 
+ * performed for every insertion, while conversions from doubles or 32-bit integers to narrower 
+ * storage types are performed directly rather than through the HDF5 library.
+ */
+
+bool HDF5_write_buffer::uses(const H5::DataType& HDT) {
+    if (HDT.getId()!=checked_id) {
+        checked_result=(HDT==type);
+        checked_id=HDT.getId();
+    }
+    return checked_result;
+}
+
+// Direct conversions are only performed from doubles to single precision, or from 32-bit integers to narrower integers.
+bool HDF5_write_buffer::narrows(const H5::DataType& HDT) const {
+    switch (storage) {
+        case DEFAULT_STORAGE:
+            return false;
+        case FLOAT_STORAGE:
+            return HDT.getClass()==H5T_FLOAT && HDT.getSize()==sizeof(double);
+        default:
+            return HDT.getClass()==H5T_INTEGER && HDT.getSize()==sizeof(int) && H5Tget_sign(HDT.getId())==H5T_SGN_2;
+    }
+}
+
+const char* HDF5_write_buffer::convert_in(const char* in, size_t n, const H5::DataType& HDT) {
+    if (uses(HDT)) {
+        return in;
+    }
+    const size_t insize=HDT.getSize();
+    scratch.resize(n*std::max(elsize, insize));
+    if (narrows(HDT) && storage==FLOAT_STORAGE) {
+        narrow_HDF5_values(storage, reinterpret_cast<const double*>(in), n, scratch.data());
+    } else if (narrows(HDT)) {
+        narrow_HDF5_values(storage, reinterpret_cast<const int*>(in), n, scratch.data());
+    } else {
+        std::copy(in, in + n*insize, scratch.data());
+        HDT.convert(type, n, scratch.data(), NULL);
+    }
+    return scratch.data();
+}
+
+void HDF5_write_buffer::convert_out(char* out, size_t n, const H5::DataType& HDT) {
+    const size_t outsize=HDT.getSize();
+    if (narrows(HDT) && storage==FLOAT_STORAGE) {
+        widen_HDF5_values(storage, scratch.data(), n, reinterpret_cast<double*>(out));
+    } else if (narrows(HDT)) {
+        widen_HDF5_values(storage, scratch.data(), n, reinterpret_cast<int*>(out));
+    } else {
+        type.convert(HDT, n, scratch.data(), NULL);
+        std::copy(scratch.data(), scratch.data() + n*outsize, out);
+    }
+    return;
+}
+
+bool HDF5_write_buffer::contains(size_t first_row, size_t last_row, size_t first_col, size_t last_col) const {
+    if (!pending) {
+        return false;
+    }
+    if (byrow) {
+        return first_row >= block_start && last_row <= block_end;
+    } else {
+        return first_col >= block_start && last_col <= block_end;
+    }
+}
+
+bool HDF5_write_buffer::overlaps(size_t first_row, size_t last_row, size_t first_col, size_t last_col) const {
+    if (!pending || first_row>=last_row || first_col>=last_col) {
+        return false;
+    }
+    if (byrow) {
+        return first_row < block_end && last_row > block_start;
+    } else {
+        return first_col < block_end && last_col > block_start;
+    }
+}
+
+/* Writing the pending block, either directly or by queueing its chunks in the pipeline.
+ * The latter is always possible as each block consists of complete chunks.
  */
 
-void reopen_HDF5_file_by_dim(const std::string& filename, const std::string& dataname, 
-        H5::H5File& hfile, H5::DataSet& hdata, const unsigned& openmode, const H5::FileAccPropList& dimlist,
-        bool& ondim, const bool& onother, const bool& largerother, const bool& dimokay) {
-    if (ondim || (onother && largerother)) {
-        ; // Don't do anything, it's okay.
-    } else if (!dimokay) {
-        std::stringstream err;
-        err << "cache size limit (" << get_cache_size_hard_limit() << ") exceeded for dim access, repack the file";
-        throw std::runtime_error(err.str().c_str());
+void HDF5_write_buffer::write(H5::DataSet& hdata) {
+    if (!pending) {
+        return;
+    }
+    if (pipeline) {
+        if (byrow) {
+            pipeline->write_block(block_start, block_end, 0, ncol, buffer.data(), hdata);
+        } else {
+            pipeline->write_block(0, nrow, block_start, block_end, buffer.data(), hdata);
+        }
     } else {
-        hdata.close();
-        hfile.close();
-        hfile.openFile(filename.c_str(), openmode, dimlist);
-        hdata = hfile.openDataSet(dataname.c_str());
-        ondim=true;
+        H5::DataSpace filespace=hdata.getSpace(), memspace;
+        select(filespace, memspace);
+        hdata.write(buffer.data(), type, memspace, filespace);
+    }
+    pending=false;
+    return;
+}
+
+void HDF5_write_buffer::flush(H5::DataSet& hdata) {
+    write(hdata);
+    if (pipeline) {
+        pipeline->finish(hdata);
+    }
+    return;
+}
+
+/* Ensuring that the region can be safely accessed through the library, by writing the 
+ * pending block and committing queued chunks if either overlaps the region.
+ */
+
+void HDF5_write_buffer::sync(size_t first_row, size_t last_row, size_t first_col, size_t last_col, H5::DataSet& hdata) {
+    if (overlaps(first_row, last_row, first_col, last_col)) {
+        write(hdata);
     }
+    if (pipeline) {
+        pipeline->wait(first_row, last_row, first_col, last_col, hdata);
+    }
+    return;
+}
+
+/* Loading a new block, after flushing the previous one. Existing values are read from 
+ * the file, which is cheap for unallocated chunks as they only contain the fill value.
+ */
+
+void HDF5_write_buffer::load(bool br, size_t index, H5::DataSet& hdata) {
+    write(hdata);
+
+    byrow=br;
+    const size_t chunk_extent=(byrow ? chunk_nr : chunk_nc), total_extent=(byrow ? nrow : ncol);
+    block_start=(index/chunk_extent)*chunk_extent;
+    block_end=std::min(block_start + chunk_extent, total_extent);
+    const size_t nblock=block_end - block_start;
+    buffer.resize(nblock*(byrow ? ncol : nrow)*elsize);
+    complete.assign(nblock, 0);
+    ncomplete=0;
+
+    if (pipeline) {
+        if (byrow) {
+            pipeline->wait(block_start, block_end, 0, ncol, hdata);
+        } else {
+            pipeline->wait(0, nrow, block_start, block_end, hdata);
+        }
+    }
+    H5::DataSpace filespace=hdata.getSpace(), memspace;
+    select(filespace, memspace);
+    hdata.read(buffer.data(), type, memspace, filespace);
+    pending=true;
+    return;
+}
+
+void HDF5_write_buffer::select(H5::DataSpace& filespace, H5::DataSpace& memspace) const {
+    hsize_t offset[2], count[2];
+    offset[0]=(byrow ? 0 : block_start); // Data are transposed in the file.
+    offset[1]=(byrow ? block_start : 0);
+    count[0]=(byrow ? ncol : block_end - block_start);
+    count[1]=(byrow ? block_end - block_start : nrow);
+    filespace.selectHyperslab(H5S_SELECT_SET, count, offset);
+    memspace.setExtentSimple(2, count);
+    return;
+}
+
+/* Copying values between the block and an external array, where the latter has
+ * rows as the fastest-changing dimension. Rows are also contiguous in the block.
+ */
+
+void HDF5_write_buffer::transfer(size_t first_row, size_t last_row, size_t first_col, size_t last_col, char* ext, bool toblock) {
+    const size_t block_nr=(byrow ? block_end - block_start : nrow);
+    const size_t row_offset=(byrow ? block_start : 0), col_offset=(byrow ? 0 : block_start);
+    const size_t nbytes=(last_row - first_row)*elsize;
+    for (size_t c=first_col; c<last_col; ++c, ext+=nbytes) {
+        char* ptr=buffer.data() + ((c - col_offset)*block_nr + first_row - row_offset)*elsize;
+        if (toblock) {
+            std::copy(ext, ext+nbytes, ptr);
+        } else {
+            std::copy(ptr, ptr+nbytes, ext);
+        }
+    }
+    return;
+}
+
+/* Methods for the memory-mapped reader. The mapping is only created for the default 
+ * (sec2) file driver without a user block, where the data set offset is the byte offset 
+ * in the file. Any pending writes from other handles to the same file are flushed first.
+ * If any requirement is not met, the mapping is left inactive and HDF5 reads are used.
+ */
+
+HDF5_mapped_data::HDF5_mapped_data() : data(NULL), nrow(0), elsize(0), checked_id(H5I_INVALID_HID), checked_result(false) {}
+
+void HDF5_mapped_data::initialize(const std::string& file, const H5::H5File& hfile, const H5::DataSet& hdata, 
+        const H5::DataType& default_type, size_t NR, size_t NC) {
+    mapping.reset();
+    data=NULL;
+#ifndef _WIN32
+    const H5::DSetCreatPropList cparms=hdata.getCreatePlist();
+    if (cparms.getLayout()!=H5D_CONTIGUOUS || cparms.getExternalCount()!=0 || !(hdata.getDataType()==default_type)) {
+        return;
+    }
+    if (default_type.getClass()==H5T_STRING && default_type.isVariableStr()) {
+        return;
+    }
+    if (hfile.getAccessPlist().getDriver()!=H5FD_SEC2 || hfile.getCreatePlist().getUserblock()!=0) {
+        return;
+    }
+
+    H5E_BEGIN_TRY {
+        H5Fflush(hfile.getId(), H5F_SCOPE_GLOBAL);
+    } H5E_END_TRY;
+    const haddr_t offset=H5Dget_offset(hdata.getId());
+    const size_t nbytes=NR*NC*default_type.getSize();
+    if (offset==HADDR_UNDEF || nbytes==0 || hdata.getStorageSize()!=nbytes) {
+        return; // Storage has not been allocated yet.
+    }
+
+    const int fd=open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info)!=0 || size_t(info.st_size) < offset + nbytes) {
+        close(fd);
+        return;
+    }
+
+    // Mapping from the start of the page containing the offset.
+    const size_t pagesize=sysconf(_SC_PAGESIZE);
+    const size_t start=(offset/pagesize)*pagesize, length=offset + nbytes - start;
+    void* ptr=mmap(NULL, length, PROT_READ, MAP_SHARED, fd, start);
+    close(fd);
+    if (ptr==MAP_FAILED) {
+        return;
+    }
+
+    mapping=std::shared_ptr<char>(static_cast<char*>(ptr), [length](char* p) -> void { munmap(p, length); });
+    data=mapping.get() + (offset - start);
+    nrow=NR;
+    elsize=default_type.getSize();
+    type.copy(default_type);
+    checked_id=default_type.getId();
+    checked_result=true;
+#endif
+    return;
+}
+
+bool HDF5_mapped_data::is_active() const {
+    return data!=NULL;
+}
+
+/* Checking whether the requested memory type is the same as the file type, 
+ * remembering the result for the last type to avoid acquiring the HDF5 lock.
+ */
+
+bool HDF5_mapped_data::uses(const H5::DataType& HDT) {
+    if (HDT.getId()!=checked_id) {
+        std::lock_guard<std::mutex> hlock(get_HDF5_mutex());
+        checked_result=(HDT==type);
+        checked_id=HDT.getId();
+    }
+    return checked_result;
+}
+
+/* Data are transposed in the file, so each column is contiguous in the mapping. */
+
+const char* HDF5_mapped_data::get_col(size_t c, size_t first) const {
+    return data + (c*nrow + first)*elsize;
+}
+
+void HDF5_mapped_data::extract_row(size_t r, size_t first, size_t last, char* out) const {
+    const char* src=get_col(first, r);
+    for (size_t c=first; c<last; ++c, src+=nrow*elsize, out+=elsize) {
+        std::copy(src, src+elsize, out);
+    }
+    return;
+}
+
+void HDF5_mapped_data::extract_col(size_t c, size_t first, size_t last, char* out) const {
+    const char* src=get_col(c, first);
+    std::copy(src, src + (last-first)*elsize, out);
+    return;
+}
+
+void HDF5_mapped_data::extract_cols(size_t first_col, size_t last_col, size_t first, size_t last, char* out) const {
+    const size_t nbytes=(last-first)*elsize;
+    for (size_t c=first_col; c<last_col; ++c, out+=nbytes) {
+        const char* src=get_col(c, first);
+        std::copy(src, src+nbytes, out);
+    }
+    return;
+}
+
+void HDF5_mapped_data::extract_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, char* out) const {
+    for (size_t i=0; i<n; ++i, ++cols, out+=elsize) {
+        const char* src=get_col(*cols, r);
+        std::copy(src, src+elsize, out);
+    }
+    return;
+}
+
+void HDF5_mapped_data::extract_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, char* out) const {
+    const char* src=get_col(c, 0);
+    for (size_t i=0; i<n; ++i, ++rows, out+=elsize) {
+        const char* cur=src + (*rows)*elsize;
+        std::copy(cur, cur+elsize, out);
+    }
+    return;
+}
+
+void HDF5_mapped_data::extract_one(size_t r, size_t c, char* out) const {
+    const char* src=get_col(c, r);
+    std::copy(src, src+elsize, out);
+    return;
 }
 
 /* These functions set the rowspace and dataspace elements according to
@@ -124,6 +858,82 @@ void HDF5_select_col(const size_t& c, const size_t& start, const size_t& end,
     return;
 }
 
+/* This selects a contiguous block of columns in a single hyperslab, 
+ * such that all of them can be read in one call. As the data are 
+ * transposed in the file, the memory space is filled column-major.
+ */
+
+void HDF5_select_cols(const size_t& first_col, const size_t& last_col, const size_t& start, const size_t& end,
+        hsize_t* cols_count, hsize_t* h5_start, 
+        H5::DataSpace& colsspace, H5::DataSpace& hspace) {
+    cols_count[0] = last_col-first_col;
+    cols_count[1] = end-start;
+    hsize_t total = cols_count[0]*cols_count[1];
+    colsspace.setExtentSimple(1, &total);
+    colsspace.selectAll();
+    h5_start[0] = first_col;
+    h5_start[1] = start;
+    hspace.selectHyperslab(H5S_SELECT_SET, cols_count, h5_start);
+    return;
+}
+
+/* These functions select an arbitrary sorted subset of columns in a row (or rows in a column).
+ * Runs of consecutive indices are merged into a union of hyperslabs, so that each chunk is
+ * only read and decompressed once. If the indices are mostly isolated, a point selection is 
+ * used instead, as it is cheaper to construct than a union of many single-element hyperslabs.
+ * In both cases, the elements are returned in the order of the (sorted) indices.
+ */
+
+void HDF5_select_subset(const size_t& fixed, const int fixed_dim, Rcpp::IntegerVector::const_iterator indices, const size_t& n,
+        H5::DataSpace& subspace, H5::DataSpace& hspace) {
+    hsize_t total=n;
+    subspace.setExtentSimple(1, &total);
+    subspace.selectAll();
+
+    size_t nruns=0;
+    for (size_t i=0; i<n; ++i) {
+        if (i==0 || indices[i]!=indices[i-1]+1) { ++nruns; }
+    }
+    const int other_dim=1-fixed_dim;
+
+    if (nruns*2 > n) { 
+        std::vector<hsize_t> coords(n*2);
+        auto cIt=coords.begin();
+        for (size_t i=0; i<n; ++i, cIt+=2) {
+            *(cIt + fixed_dim)=fixed;
+            *(cIt + other_dim)=indices[i];
+        }
+        hspace.selectElements(H5S_SELECT_SET, n, coords.data());
+    } else {
+        hsize_t h5_start[2], h5_count[2];
+        h5_start[fixed_dim]=fixed;
+        h5_count[fixed_dim]=1;
+        hspace.selectNone();
+        size_t i=0;
+        while (i < n) {
+            size_t j=i+1;
+            while (j < n && indices[j]==indices[j-1]+1) { ++j; }
+            h5_start[other_dim]=indices[i];
+            h5_count[other_dim]=j-i;
+            hspace.selectHyperslab(H5S_SELECT_OR, h5_count, h5_start);
+            i=j;
+        }
+    }
+    return;
+}
+
+void HDF5_select_row_subset(const size_t& r, Rcpp::IntegerVector::const_iterator cols, const size_t& n,
+        H5::DataSpace& rowsubspace, H5::DataSpace& hspace) {
+    HDF5_select_subset(r, 1, cols, n, rowsubspace, hspace);
+    return;
+}
+
+void HDF5_select_col_subset(const size_t& c, Rcpp::IntegerVector::const_iterator rows, const size_t& n,
+        H5::DataSpace& colsubspace, H5::DataSpace& hspace) {
+    HDF5_select_subset(c, 0, rows, n, colsubspace, hspace);
+    return;
+}
+
 void HDF5_select_one(const size_t& r, const size_t& c,
         hsize_t* one_count, hsize_t* h5_start, 
         H5::DataSpace& hspace) {
@@ -204,4 +1014,119 @@ H5::DataType set_HDF5_data_type (int RTYPE, const H5::DataSet& hdata) {
     return set_HDF5_data_type(RTYPE, 0);
 }
 
+/* Choosing the file type for the requested storage type, or identifying the storage type 
+ * from the file type. Only native types are considered, as the memory type is always native.
+ */
+
+const H5::PredType& get_HDF5_storage_predtype (storage_type storage) {
+    switch (storage) {
+        case FLOAT_STORAGE:
+            return H5::PredType::NATIVE_FLOAT;
+        case INT8_STORAGE:
+            return H5::PredType::NATIVE_INT8;
+        case UINT8_STORAGE:
+            return H5::PredType::NATIVE_UINT8;
+        case INT16_STORAGE:
+            return H5::PredType::NATIVE_INT16;
+        case UINT16_STORAGE:
+            return H5::PredType::NATIVE_UINT16;
+        default:
+            throw std::runtime_error("unsupported storage type");
+    }
+}
+
+H5::DataType set_HDF5_storage_type (int RTYPE, storage_type storage, const H5::DataType& default_type) {
+    switch (storage) {
+        case DEFAULT_STORAGE:
+            return default_type;
+        case FLOAT_STORAGE:
+            if (RTYPE!=REALSXP) {
+                throw std::runtime_error("single-precision storage is only supported for numeric output");
+            }
+            break;
+        default:
+            if (RTYPE!=INTSXP && RTYPE!=LGLSXP) {
+                throw std::runtime_error("narrow integer storage is only supported for integer or logical output");
+            }
+    }
+    return H5::DataType(get_HDF5_storage_predtype(storage));
+}
+
+storage_type find_HDF5_storage_type (int RTYPE, const H5::DataSet& hdata) {
+    std::vector<storage_type> candidates;
+    if (RTYPE==REALSXP) {
+        candidates.push_back(FLOAT_STORAGE);
+    } else if (RTYPE==INTSXP || RTYPE==LGLSXP) {
+        candidates={ INT8_STORAGE, UINT8_STORAGE, INT16_STORAGE, UINT16_STORAGE };
+    }
+    
+    const H5::DataType curtype=hdata.getDataType();
+    for (auto s : candidates) {
+        if (curtype==get_HDF5_storage_predtype(s)) {
+            return s;
+        }
+    }
+    return DEFAULT_STORAGE;
+}
+
+/* Conversions between the storage type and the memory type. Narrowing does not check 
+ * whether the values are representable, so this should be done beforehand if necessary.
+ */
+
+void widen_HDF5_values (storage_type storage, const char* in, size_t n, int* out) {
+    switch (storage) {
+        case INT8_STORAGE:
+            copy_values(reinterpret_cast<const int8_t*>(in), n, out);
+            break;
+        case UINT8_STORAGE:
+            copy_values(reinterpret_cast<const uint8_t*>(in), n, out);
+            break;
+        case INT16_STORAGE:
+            copy_values(reinterpret_cast<const int16_t*>(in), n, out);
+            break;
+        case UINT16_STORAGE:
+            copy_values(reinterpret_cast<const uint16_t*>(in), n, out);
+            break;
+        default:
+            throw std::runtime_error("stored values cannot be widened to integers");
+    }
+    return;
+}
+
+void widen_HDF5_values (storage_type storage, const char* in, size_t n, double* out) {
+    if (storage!=FLOAT_STORAGE) {
+        throw std::runtime_error("stored values cannot be widened to doubles");
+    }
+    copy_values(reinterpret_cast<const float*>(in), n, out);
+    return;
+}
+
+void narrow_HDF5_values (storage_type storage, const int* in, size_t n, char* out) {
+    switch (storage) {
+        case INT8_STORAGE:
+            copy_values(in, n, reinterpret_cast<int8_t*>(out));
+            break;
+        case UINT8_STORAGE:
+            copy_values(in, n, reinterpret_cast<uint8_t*>(out));
+            break;
+        case INT16_STORAGE:
+            copy_values(in, n, reinterpret_cast<int16_t*>(out));
+            break;
+        case UINT16_STORAGE:
+            copy_values(in, n, reinterpret_cast<uint16_t*>(out));
+            break;
+        default:
+            throw std::runtime_error("integers cannot be narrowed to the storage type");
+    }
+    return;
+}
+
+void narrow_HDF5_values (storage_type storage, const double* in, size_t n, char* out) {
+    if (storage!=FLOAT_STORAGE) {
+        throw std::runtime_error("doubles cannot be narrowed to the storage type");
+    }
+    copy_values(in, n, reinterpret_cast<float*>(out));
+    return;
+}
+
 }
@@ -6,15 +6,192 @@
 
 namespace beachmat { 
 
-size_t get_cache_size_hard_limit();
+size_t get_default_cache_size();
 
 void calc_HDF5_chunk_cache_settings (const size_t, const size_t, const H5::DSetCreatPropList&, const H5::DataType&,
-        bool&, bool&, bool&, bool&, bool&, bool&,
-        H5::FileAccPropList&, H5::FileAccPropList&);
+        const size_t, bool&, bool&, H5::DSetAccPropList&);
 
-void reopen_HDF5_file_by_dim(const std::string&, const std::string&, 
-        H5::H5File&, H5::DataSet&, const unsigned&, const H5::FileAccPropList&,
-        bool&, const bool&, const bool&, const bool&);
+/* Buffer for strip-mined access, used when all chunks along a row (or column) do not fit in the cache.
+ * This reads a block of consecutive rows (or columns) in a single call, such that each chunk 
+ * is decompressed once per block rather than once per row (or column).
+ */
+
+class HDF5_block_buffer {
+public:
+    HDF5_block_buffer();
+    HDF5_block_buffer(bool, size_t, size_t, size_t);
+    void extract(size_t, size_t, size_t, char*, const H5::DataType&, const H5::DataSet&, H5::DataSpace&);
+private:
+    bool byrow;
+    size_t budget, chunk_extent, total_extent;
+
+    bool filled;
+    size_t block_start, block_end, block_first, block_last;
+    H5::DataType block_type;
+    std::vector<char> buffer;
+    H5::DataSpace blockspace;
+    hsize_t block_offset[2], block_count[2];
+};
+
+/* Global lock for HDF5 library calls, which are not guaranteed to be thread-safe.
+ * This must be held by any beachmat method that calls the HDF5 library, 
+ * as a prefetching thread may be reading from another data set at the same time.
+ */
+
+std::mutex& get_HDF5_mutex();
+
+/* Markers that hold the global lock while the HDF5 members of an enclosing class are constructed, 
+ * copied (e.g., when cloning) or destroyed, as the HDF5 C++ classes call the library in all of these
+ * operations, which may otherwise run concurrently with other threads that are using the library.
+ * The opening marker must be declared before all HDF5 members and the closing marker after them.
+ * Members are constructed in order of declaration and destroyed in reverse order, so the lock is 
+ * acquired by whichever marker is handled first and released by the other. Members that need the
+ * lock themselves (e.g., prefetchers whose threads read from the file) must be declared outside.
+ */
+
+class HDF5_lock_open {
+public:
+    HDF5_lock_open();
+    HDF5_lock_open(const HDF5_lock_open&);
+    HDF5_lock_open& operator=(const HDF5_lock_open&) = delete;
+    ~HDF5_lock_open();
+};
+
+class HDF5_lock_close {
+public:
+    HDF5_lock_close();
+    HDF5_lock_close(const HDF5_lock_close&);
+    HDF5_lock_close& operator=(const HDF5_lock_close&) = delete;
+    ~HDF5_lock_close();
+};
+
+/* Prefetcher for sequential access, which reads the next chunk-aligned block of 
+ * rows (or columns) in a separate thread while the current block is being used.
+ */
+
+class HDF5_prefetcher {
+public:
+    HDF5_prefetcher();
+    HDF5_prefetcher(bool, size_t, size_t, size_t, size_t);
+    ~HDF5_prefetcher();
+
+    // Copies only the settings; each copy starts its own thread when required.
+    HDF5_prefetcher(const HDF5_prefetcher&);
+    HDF5_prefetcher& operator=(const HDF5_prefetcher&);
+
+    void extract(size_t, size_t, size_t, char*, const H5::DataType&, const H5::DataSet&);
+private:
+    bool byrow;
+    size_t budget, chunk_extent, total_extent, other_extent;
+
+    // Current block being served, and the pending block being read by the thread.
+    struct block {
+        block();
+        bool valid;
+        size_t start, end;
+        std::vector<char> data;
+    } current, pending;
+
+    std::unique_ptr<H5::DataType> block_type; // Only created and destroyed while holding the lock.
+    hid_t block_id;
+    size_t elsize, nblock, last_index;
+
+    void find_block(size_t, size_t&, size_t&) const;
+    void request(size_t, const H5::DataSet&);
+    void wait();
+    void stop();
+    void run();
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable cv;
+    bool busy, finished;
+    const H5::DataSet* source;
+    std::exception_ptr error;
+};
+
+/* Write-back buffer for a chunk-aligned block of columns (or rows) of an output data set.
+ * Insertions are accumulated in memory and the block is written with a single call once 
+ * all of its columns (or rows) are complete, when another block is required, or on flush().
+ * This avoids repeated recompression of partially written chunks. The buffer cannot be copied;
+ * instead, a single instance should be shared by all copies of an output matrix (e.g., clones),
+ * as separate buffers would overwrite each other's values when writing back the same block.
+ * All methods must be called while holding the HDF5 lock. If a pipeline is set, written 
+ * blocks are compressed in the background by a HDF5_chunk_writer.
+ */
+
+class HDF5_chunk_writer;
+
+class HDF5_write_buffer {
+public:
+    HDF5_write_buffer();
+    HDF5_write_buffer(size_t, size_t, size_t, size_t, const H5::DataType&, size_t, storage_type=DEFAULT_STORAGE);
+
+    HDF5_write_buffer(const HDF5_write_buffer&) = delete;
+    HDF5_write_buffer& operator=(const HDF5_write_buffer&) = delete;
+
+    bool insert(bool, size_t, size_t, size_t, const char*, const H5::DataType&, H5::DataSet&);
+    bool insert_one(size_t, size_t, const char*, const H5::DataType&, H5::DataSet&);
+    bool extract(bool, size_t, size_t, size_t, char*, const H5::DataType&, H5::DataSet&);
+    bool extract_one(size_t, size_t, char*, const H5::DataType&, H5::DataSet&);
+    void flush(H5::DataSet&);
+
+    void set_pipeline(const H5::DataSet&, size_t);
+private:
+    size_t nrow, ncol, chunk_nr, chunk_nc, budget, elsize;
+    H5::DataType type;
+    storage_type storage; // Whether the file type is narrower than the memory type, for fast conversions.
+    hid_t checked_id;
+    bool checked_result;
+
+    bool pending, byrow;
+    size_t block_start, block_end, ncomplete;
+    std::vector<char> buffer, scratch;
+    std::vector<unsigned char> complete;
+    std::shared_ptr<HDF5_chunk_writer> pipeline;
+
+    bool fits(bool) const;
+    bool contains(size_t, size_t, size_t, size_t) const;
+    bool overlaps(size_t, size_t, size_t, size_t) const;
+    void load(bool, size_t, H5::DataSet&);
+    void write(H5::DataSet&);
+    void sync(size_t, size_t, size_t, size_t, H5::DataSet&);
+    void transfer(size_t, size_t, size_t, size_t, char*, bool);
+    void select(H5::DataSpace&, H5::DataSpace&) const;
+
+    bool uses(const H5::DataType&);
+    bool narrows(const H5::DataType&) const;
+    const char* convert_in(const char*, size_t, const H5::DataType&);
+    void convert_out(char*, size_t, const H5::DataType&);
+};
+
+/* Read-only memory mapping of a contiguous, uncompressed data set in native byte order.
+ * Values can then be copied (or referenced) directly from the file without calling the HDF5 library.
+ * The mapping is shared between copies and released when the last copy is destroyed.
+ */
+
+class HDF5_mapped_data {
+public:
+    HDF5_mapped_data();
+    void initialize(const std::string&, const H5::H5File&, const H5::DataSet&, const H5::DataType&, size_t, size_t);
+    bool is_active() const;
+    bool uses(const H5::DataType&);
+
+    const char* get_col(size_t, size_t) const;
+    void extract_row(size_t, size_t, size_t, char*) const;
+    void extract_col(size_t, size_t, size_t, char*) const;
+    void extract_cols(size_t, size_t, size_t, size_t, char*) const;
+    void extract_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, char*) const;
+    void extract_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, char*) const;
+    void extract_one(size_t, size_t, char*) const;
+private:
+    std::shared_ptr<char> mapping;
+    const char* data;
+    size_t nrow, elsize;
+    H5::DataType type;
+    hid_t checked_id;
+    bool checked_result;
+};
 
 void HDF5_select_row(const size_t&, const size_t&, const size_t&,
         hsize_t*, hsize_t*, 
@@ -24,6 +201,16 @@ void HDF5_select_col(const size_t&, const size_t&, const size_t&,
         hsize_t*, hsize_t*, 
         H5::DataSpace&, H5::DataSpace&);
 
+void HDF5_select_cols(const size_t&, const size_t&, const size_t&, const size_t&,
+        hsize_t*, hsize_t*, 
+        H5::DataSpace&, H5::DataSpace&);
+
+void HDF5_select_row_subset(const size_t&, Rcpp::IntegerVector::const_iterator, const size_t&,
+        H5::DataSpace&, H5::DataSpace&);
+
+void HDF5_select_col_subset(const size_t&, Rcpp::IntegerVector::const_iterator, const size_t&,
+        H5::DataSpace&, H5::DataSpace&);
+
 void HDF5_select_one(const size_t&, const size_t&,
         hsize_t*, hsize_t*, 
         H5::DataSpace& hspace);
@@ -32,6 +219,29 @@ H5::DataType set_HDF5_data_type (int, const H5::DataSet&);
 
 H5::DataType set_HDF5_data_type (int, size_t);
 
+/* Narrower types for storing values in the file. Values are read in the storage type 
+ * and widened by beachmat, which is faster than HDF5's generic type conversion.
+ */
+
+const H5::PredType& get_HDF5_storage_predtype (storage_type);
+
+H5::DataType set_HDF5_storage_type (int, storage_type, const H5::DataType&);
+
+storage_type find_HDF5_storage_type (int, const H5::DataSet&);
+
+void widen_HDF5_values (storage_type, const char*, size_t, int*);
+
+void widen_HDF5_values (storage_type, const char*, size_t, double*);
+
+template<typename X>
+void widen_HDF5_values (storage_type, const char*, size_t, X*) {
+    throw std::runtime_error("stored values cannot be widened to the requested type");
+}
+
+void narrow_HDF5_values (storage_type, const int*, size_t, char*);
+
+void narrow_HDF5_values (storage_type, const double*, size_t, char*);
+
 void initialize_HDF5_size_arrays (const size_t&, const size_t&,
         hsize_t*, hsize_t*, hsize_t*, 
         hsize_t*, H5::DataSpace&);
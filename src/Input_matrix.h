@@ -4,6 +4,7 @@
 #include "beachmat.h"
 #include "any_matrix.h"
 #include "utils.h"
+#include "input_param.h"
 
 #include "simple_matrix.h"
 #include "dense_matrix.h"
@@ -5,6 +5,20 @@
 
 namespace beachmat { 
 
+/* Read-only view of the non-zero entries in a column, containing the number of entries 
+ * and iterators to their row indices and values. This is only valid until the next call
+ * to get_const_nonzero_col() (or until the matrix is destroyed).
+ */
+
+template<class V>
+class const_nonzero_view {
+public:
+    const_nonzero_view();
+    size_t n;
+    Rcpp::IntegerVector::const_iterator index;
+    typename V::const_iterator value;
+};
+
 /***************************************************************** 
  * Virtual base class for LIN (logical/integer/numeric) matrices. 
  *****************************************************************/
@@ -20,20 +34,52 @@ public:
 
     void get_row(size_t, Rcpp::IntegerVector::iterator);
     void get_row(size_t, Rcpp::NumericVector::iterator);
+    void get_row(size_t, float*);
 
     /* We can't add a LogicalVector::iterator method because IntegerVector::iterator==LogicalVector::iterator
      * under the hood in Rcpp. The compiler then complains that overloading is not possible. Thus, for all 
      * references here to LogicalVector, we will consider the use of IntegerVector in its place.
+     *
+     * The same equivalence means that int* and double* (e.g., from std::vector::data()) can be passed 
+     * directly, as these are the underlying types of the Rcpp iterators. float* methods are also provided
+     * to extract single-precision values without an intermediate double-precision copy.
      */
 
     virtual void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t)=0;
     virtual void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t)=0;
+    virtual void get_row(size_t, float*, size_t, size_t)=0;
+
+    void get_row(size_t, Rcpp::IntegerVector::iterator, row_cursor&);
+    void get_row(size_t, Rcpp::NumericVector::iterator, row_cursor&);
+    void get_row(size_t, float*, row_cursor&);
+
+    virtual void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t, row_cursor&);
+    virtual void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t, row_cursor&);
+    virtual void get_row(size_t, float*, size_t, size_t, row_cursor&);
 
     void get_col(size_t, Rcpp::IntegerVector::iterator);
     void get_col(size_t, Rcpp::NumericVector::iterator);
+    void get_col(size_t, float*);
 
     virtual void get_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t)=0;
     virtual void get_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t)=0;
+    virtual void get_col(size_t, float*, size_t, size_t)=0;
+
+    void get_cols(size_t, size_t, Rcpp::IntegerVector::iterator);
+    void get_cols(size_t, size_t, Rcpp::NumericVector::iterator);
+    void get_cols(size_t, size_t, float*);
+
+    virtual void get_cols(size_t, size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
+    virtual void get_cols(size_t, size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    virtual void get_cols(size_t, size_t, float*, size_t, size_t);
+
+    virtual void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::IntegerVector::iterator);
+    virtual void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::NumericVector::iterator);
+    virtual void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, float*);
+
+    virtual void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::IntegerVector::iterator);
+    virtual void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::NumericVector::iterator);
+    virtual void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, float*);
 
     virtual T get(size_t, size_t)=0;
 
@@ -42,20 +88,41 @@ public:
 
     size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator);
     size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator);
+    size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, float*);
 
     virtual size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator, size_t, size_t);
     virtual size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator, size_t, size_t);
+    virtual size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, float*, size_t, size_t);
+
+    const_nonzero_view<V> get_const_nonzero_col(size_t);
+    virtual const_nonzero_view<V> get_const_nonzero_col(size_t, size_t, size_t);
 
     size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator);
     size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator);
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, float*);
 
     virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator, size_t, size_t);
     virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator, size_t, size_t);
+    virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, float*, size_t, size_t);
+
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator, row_cursor&);
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator, row_cursor&);
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, float*, row_cursor&);
+
+    virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator, size_t, size_t, row_cursor&);
+    virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator, size_t, size_t, row_cursor&);
+    virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, float*, size_t, size_t, row_cursor&);
+
+    void enable_row_index();
+    virtual void enable_row_index(size_t);
 
     virtual std::unique_ptr<lin_matrix<T, V> > clone() const=0;
 
     virtual Rcpp::RObject yield() const=0;
     virtual matrix_type get_matrix_type() const=0;
+protected:
+    std::vector<int> nonzero_index; // Workspaces for the default get_const_nonzero_col().
+    std::vector<T> nonzero_value;
 };
 
 /* Various flavours of a LIN matrix */
@@ -71,9 +138,23 @@ public:
 
     void get_col(size_t,  Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_col(size_t,  Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_col(size_t,  float*, size_t, size_t);
+
+    void get_cols(size_t, size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
+    void get_cols(size_t, size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_cols(size_t, size_t, float*, size_t, size_t);
 
     void get_row(size_t,  Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_row(size_t,  Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_row(size_t,  float*, size_t, size_t);
+
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::IntegerVector::iterator);
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::NumericVector::iterator);
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, float*);
+
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::IntegerVector::iterator);
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::NumericVector::iterator);
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, float*);
 
     T get(size_t, size_t);
 
@@ -115,9 +196,23 @@ public:
 
     virtual size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator, size_t, size_t);
     virtual size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator, size_t, size_t);
+    virtual size_t get_nonzero_col(size_t, Rcpp::IntegerVector::iterator, float*, size_t, size_t);
+
+    const_nonzero_view<V> get_const_nonzero_col(size_t, size_t, size_t);
 
     virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator, size_t, size_t);
     virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator, size_t, size_t);
+    virtual size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, float*, size_t, size_t);
+
+    void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t, row_cursor&);
+    void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t, row_cursor&);
+    void get_row(size_t, float*, size_t, size_t, row_cursor&);
+
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::IntegerVector::iterator, size_t, size_t, row_cursor&);
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, Rcpp::NumericVector::iterator, size_t, size_t, row_cursor&);
+    size_t get_nonzero_row(size_t, Rcpp::IntegerVector::iterator, float*, size_t, size_t, row_cursor&);
+
+    void enable_row_index(size_t);
 
     std::unique_ptr<lin_matrix<T, V> > clone() const;
 };
@@ -126,14 +221,25 @@ template <typename T, class V>
 using Psymm_lin_matrix=advanced_lin_matrix<T, V, Psymm_matrix<T, V> >;
 
 template <typename T, class V>
-using Rle_lin_matrix=advanced_lin_matrix<T, V, Rle_matrix<T, V> >;
+class Rle_lin_matrix : public advanced_lin_matrix<T, V, Rle_matrix<T, V> > {
+public:
+    Rle_lin_matrix(const Rcpp::RObject&);
+    ~Rle_lin_matrix();
+
+    void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t, row_cursor&);
+    void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t, row_cursor&);
+    void get_row(size_t, float*, size_t, size_t, row_cursor&);
+
+    std::unique_ptr<lin_matrix<T, V> > clone() const;
+};
 
 /* HDF5Matrix of LINs */
 
 template<typename T, class V, int RTYPE>
 class HDF5_lin_matrix : public lin_matrix<T, V> {
 public:
-    HDF5_lin_matrix(const Rcpp::RObject&);
+    HDF5_lin_matrix(const Rcpp::RObject&, size_t=input_param::DEFAULT_CACHE_SIZE, bool=input_param::DEFAULT_PREFETCH, 
+            bool=input_param::DEFAULT_SHARED_CACHE, size_t=input_param::DEFAULT_THREADS);
     ~HDF5_lin_matrix();
 
     size_t get_nrow() const;
@@ -141,12 +247,28 @@ public:
 
     void get_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_col(size_t, float*, size_t, size_t);
+
+    void get_cols(size_t, size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
+    void get_cols(size_t, size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_cols(size_t, size_t, float*, size_t, size_t);
 
     void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_row(size_t, float*, size_t, size_t);
+
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::IntegerVector::iterator);
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::NumericVector::iterator);
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, float*);
+
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::IntegerVector::iterator);
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::NumericVector::iterator);
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, float*);
 
     T get(size_t, size_t);
 
+    typename V::const_iterator get_const_col(size_t, typename V::iterator, size_t, size_t);
+
     std::unique_ptr<lin_matrix<T, V> > clone() const;
 
     Rcpp::RObject yield() const;
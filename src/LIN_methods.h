@@ -7,6 +7,9 @@ namespace beachmat {
  * Defining the common input interface. 
  ****************************************/
 
+template<class V>
+const_nonzero_view<V>::const_nonzero_view() : n(0), index(NULL), value(NULL) {}
+
 template<typename T, class V>
 lin_matrix<T, V>::lin_matrix() {}
 
@@ -25,6 +28,114 @@ void lin_matrix<T, V>::get_col(size_t c, Rcpp::NumericVector::iterator out) {
     return;
 }
 
+template<typename T, class V>
+void lin_matrix<T, V>::get_col(size_t c, float* out) {
+    get_col(c, out, 0, get_nrow());
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_cols(size_t first_col, size_t last_col, Rcpp::IntegerVector::iterator out) {
+    get_cols(first_col, last_col, out, 0, get_nrow());
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_cols(size_t first_col, size_t last_col, Rcpp::NumericVector::iterator out) {
+    get_cols(first_col, last_col, out, 0, get_nrow());
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_cols(size_t first_col, size_t last_col, float* out) {
+    get_cols(first_col, last_col, out, 0, get_nrow());
+    return;
+}
+
+/* The default block extraction simply calls get_col for each column. 
+ * Derived classes should override it if they have something more efficient.
+ */
+
+template<class M, class Iter>
+void fill_cols_by_col(M* ptr, size_t first_col, size_t last_col, Iter out, size_t first, size_t last) {
+    if (last_col < first_col) {
+        throw std::runtime_error("column start index is greater than column end index");
+    }
+    const size_t nvals=last-first;
+    for (size_t c=first_col; c<last_col; ++c, out+=nvals) {
+        ptr->get_col(c, out, first, last);
+    }
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_cols(size_t first_col, size_t last_col, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
+    fill_cols_by_col(this, first_col, last_col, out, first, last);
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_cols(size_t first_col, size_t last_col, Rcpp::NumericVector::iterator out, size_t first, size_t last) {
+    fill_cols_by_col(this, first_col, last_col, out, first, last);
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_cols(size_t first_col, size_t last_col, float* out, size_t first, size_t last) {
+    fill_cols_by_col(this, first_col, last_col, out, first, last);
+    return;
+}
+
+/* The default subset extraction calls get for each entry. */
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::IntegerVector::iterator out) {
+    for (size_t i=0; i<n; ++i, ++cols, ++out) {
+        (*out)=get(r, *cols);
+    }
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::NumericVector::iterator out) {
+    for (size_t i=0; i<n; ++i, ++cols, ++out) {
+        (*out)=get(r, *cols);
+    }
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, float* out) {
+    for (size_t i=0; i<n; ++i, ++cols, ++out) {
+        (*out)=get(r, *cols);
+    }
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::IntegerVector::iterator out) {
+    for (size_t i=0; i<n; ++i, ++rows, ++out) {
+        (*out)=get(*rows, c);
+    }
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::NumericVector::iterator out) {
+    for (size_t i=0; i<n; ++i, ++rows, ++out) {
+        (*out)=get(*rows, c);
+    }
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, float* out) {
+    for (size_t i=0; i<n; ++i, ++rows, ++out) {
+        (*out)=get(*rows, c);
+    }
+    return;
+}
+
 template<typename T, class V>
 void lin_matrix<T, V>::get_row(size_t r, Rcpp::IntegerVector::iterator out) {
     get_row(r, out, 0, get_ncol());
@@ -37,6 +148,50 @@ void lin_matrix<T, V>::get_row(size_t r, Rcpp::NumericVector::iterator out) {
     return;
 }
 
+template<typename T, class V>
+void lin_matrix<T, V>::get_row(size_t r, float* out) {
+    get_row(r, out, 0, get_ncol());
+    return;
+}
+
+/* Row cursors are only relevant for some matrix types, so the default ignores them. */
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row(size_t r, Rcpp::IntegerVector::iterator out, row_cursor& cur) {
+    get_row(r, out, 0, get_ncol(), cur);
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row(size_t r, Rcpp::NumericVector::iterator out, row_cursor& cur) {
+    get_row(r, out, 0, get_ncol(), cur);
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row(size_t r, float* out, row_cursor& cur) {
+    get_row(r, out, 0, get_ncol(), cur);
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    get_row(r, out, first, last);
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row(size_t r, Rcpp::NumericVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    get_row(r, out, first, last);
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::get_row(size_t r, float* out, size_t first, size_t last, row_cursor& cur) {
+    get_row(r, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 typename V::const_iterator lin_matrix<T, V>::get_const_col(size_t c, typename V::iterator work) {
     return get_const_col(c, work, 0, get_nrow());
@@ -58,6 +213,11 @@ size_t lin_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iterator
     return get_nonzero_col(c, dex, out, 0, get_nrow());
 }
 
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iterator dex, float* out) {
+    return get_nonzero_col(c, dex, out, 0, get_nrow());
+}
+
 template<typename T, class V>
 size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, Rcpp::IntegerVector::iterator out) {
     return get_nonzero_row(r, dex, out, 0, get_ncol());
@@ -68,6 +228,11 @@ size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator
     return get_nonzero_row(r, dex, out, 0, get_ncol());
 }
 
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, float* out) {
+    return get_nonzero_row(r, dex, out, 0, get_ncol());
+}
+
 template<class T, class Iter>
 size_t zero_hunter(Rcpp::IntegerVector::iterator index, Iter val, size_t first, size_t last) {
     size_t nzero=0;
@@ -98,6 +263,45 @@ size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator
     return zero_hunter<double>(index, val, first, last);
 }
 
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator index, float* val, size_t first, size_t last) {
+    get_row(r, val, first, last);
+    return zero_hunter<float>(index, val, first, last);
+}
+
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, Rcpp::IntegerVector::iterator out, row_cursor& cur) {
+    return get_nonzero_row(r, dex, out, 0, get_ncol(), cur);
+}
+
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, Rcpp::NumericVector::iterator out, row_cursor& cur) {
+    return get_nonzero_row(r, dex, out, 0, get_ncol(), cur);
+}
+
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, float* out, row_cursor& cur) {
+    return get_nonzero_row(r, dex, out, 0, get_ncol(), cur);
+}
+
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator index, Rcpp::IntegerVector::iterator val, size_t first, size_t last, row_cursor& cur) {
+    get_row(r, val, first, last, cur);
+    return zero_hunter<int>(index, val, first, last);
+}
+
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator index, Rcpp::NumericVector::iterator val, size_t first, size_t last, row_cursor& cur) {
+    get_row(r, val, first, last, cur);
+    return zero_hunter<double>(index, val, first, last);
+}
+
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator index, float* val, size_t first, size_t last, row_cursor& cur) {
+    get_row(r, val, first, last, cur);
+    return zero_hunter<float>(index, val, first, last);
+}
+
 template<typename T, class V>
 size_t lin_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iterator index, Rcpp::IntegerVector::iterator val, size_t first, size_t last) {
     get_col(c, val, first, last);
@@ -110,6 +314,46 @@ size_t lin_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iterator
     return zero_hunter<double>(index, val, first, last);
 }
 
+template<typename T, class V>
+size_t lin_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iterator index, float* val, size_t first, size_t last) {
+    get_col(c, val, first, last);
+    return zero_hunter<float>(index, val, first, last);
+}
+
+/* The default non-zero view fills internal workspaces via get_nonzero_col. */
+
+template<typename T, class V>
+const_nonzero_view<V> lin_matrix<T, V>::get_const_nonzero_col(size_t c) {
+    return get_const_nonzero_col(c, 0, get_nrow());
+}
+
+template<typename T, class V>
+const_nonzero_view<V> lin_matrix<T, V>::get_const_nonzero_col(size_t c, size_t first, size_t last) {
+    if (last > first && nonzero_index.size() < last - first) {
+        nonzero_index.resize(last - first);
+        nonzero_value.resize(last - first);
+    }
+
+    const_nonzero_view<V> output;
+    output.n=get_nonzero_col(c, nonzero_index.data(), nonzero_value.data(), first, last);
+    output.index=nonzero_index.data();
+    output.value=nonzero_value.data();
+    return output;
+}
+
+/* Row indexing is only relevant for some matrix types, so the default does nothing. */
+
+template<typename T, class V>
+void lin_matrix<T, V>::enable_row_index() {
+    enable_row_index(get_row_index_size_limit());
+    return;
+}
+
+template<typename T, class V>
+void lin_matrix<T, V>::enable_row_index(size_t limit) {
+    return;
+}
+
 /* Defining the advanced interface. */
 
 template<typename T, class V, class M>
@@ -140,6 +384,30 @@ void advanced_lin_matrix<T, V, M>::get_col(size_t c, Rcpp::NumericVector::iterat
     return;
 }
 
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_col(size_t c, float* out, size_t first, size_t last) {
+    mat.get_col(c, out, first, last);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_cols(size_t first_col, size_t last_col, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
+    mat.get_cols(first_col, last_col, out, first, last);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_cols(size_t first_col, size_t last_col, Rcpp::NumericVector::iterator out, size_t first, size_t last) {
+    mat.get_cols(first_col, last_col, out, first, last);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_cols(size_t first_col, size_t last_col, float* out, size_t first, size_t last) {
+    mat.get_cols(first_col, last_col, out, first, last);
+    return;
+}
+
 template<typename T, class V, class M>
 void advanced_lin_matrix<T, V, M>::get_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.get_row(r, out, first, last);
@@ -152,6 +420,48 @@ void advanced_lin_matrix<T, V, M>::get_row(size_t r, Rcpp::NumericVector::iterat
     return;
 }
 
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_row(size_t r, float* out, size_t first, size_t last) {
+    mat.get_row(r, out, first, last);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::IntegerVector::iterator out) {
+    mat.get_row_subset(r, cols, n, out);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::NumericVector::iterator out) {
+    mat.get_row_subset(r, cols, n, out);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, float* out) {
+    mat.get_row_subset(r, cols, n, out);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::IntegerVector::iterator out) {
+    mat.get_col_subset(c, rows, n, out);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::NumericVector::iterator out) {
+    mat.get_col_subset(c, rows, n, out);
+    return;
+}
+
+template<typename T, class V, class M>
+void advanced_lin_matrix<T, V, M>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, float* out) {
+    mat.get_col_subset(c, rows, n, out);
+    return;
+}
+
 template<typename T, class V, class M>
 T advanced_lin_matrix<T, V, M>::get(size_t r, size_t c) {
     return mat.get(r, c);
@@ -224,6 +534,11 @@ size_t Csparse_lin_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::
     return this->mat.get_nonzero_col(c, dex, out, first, last);
 }
 
+template <typename T, class V>
+size_t Csparse_lin_matrix<T, V>::get_nonzero_col(size_t c, Rcpp::IntegerVector::iterator dex, float* out, size_t first, size_t last) {
+    return this->mat.get_nonzero_col(c, dex, out, first, last);
+}
+
 template <typename T, class V>
 size_t Csparse_lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     return this->mat.get_nonzero_row(r, dex, out, first, last);
@@ -234,15 +549,98 @@ size_t Csparse_lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::
     return this->mat.get_nonzero_row(r, dex, out, first, last);
 }
 
+template <typename T, class V>
+size_t Csparse_lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, float* out, size_t first, size_t last) {
+    return this->mat.get_nonzero_row(r, dex, out, first, last);
+}
+
+template <typename T, class V>
+const_nonzero_view<V> Csparse_lin_matrix<T, V>::get_const_nonzero_col(size_t c, size_t first, size_t last) {
+    const_nonzero_view<V> output;
+    output.n=this->mat.get_const_nonzero_col(c, output.index, output.value, first, last);
+    return output;
+}
+
+template <typename T, class V>
+void Csparse_lin_matrix<T, V>::get_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    this->mat.get_row(r, out, first, last, cur);
+    return;
+}
+
+template <typename T, class V>
+void Csparse_lin_matrix<T, V>::get_row(size_t r, Rcpp::NumericVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    this->mat.get_row(r, out, first, last, cur);
+    return;
+}
+
+template <typename T, class V>
+void Csparse_lin_matrix<T, V>::get_row(size_t r, float* out, size_t first, size_t last, row_cursor& cur) {
+    this->mat.get_row(r, out, first, last, cur);
+    return;
+}
+
+template <typename T, class V>
+size_t Csparse_lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, Rcpp::IntegerVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    return this->mat.get_nonzero_row(r, dex, out, first, last, cur);
+}
+
+template <typename T, class V>
+size_t Csparse_lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, Rcpp::NumericVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    return this->mat.get_nonzero_row(r, dex, out, first, last, cur);
+}
+
+template <typename T, class V>
+size_t Csparse_lin_matrix<T, V>::get_nonzero_row(size_t r, Rcpp::IntegerVector::iterator dex, float* out, size_t first, size_t last, row_cursor& cur) {
+    return this->mat.get_nonzero_row(r, dex, out, first, last, cur);
+}
+
+template <typename T, class V>
+void Csparse_lin_matrix<T, V>::enable_row_index(size_t limit) {
+    this->mat.enable_row_index(limit);
+    return;
+}
+
 template <typename T, class V>
 std::unique_ptr<lin_matrix<T, V> > Csparse_lin_matrix<T, V>::clone() const {
     return std::unique_ptr<lin_matrix<T, V> >(new Csparse_lin_matrix<T, V>(*this));
 }
 
+/* Defining specific interface for RLE matrices. */
+
+template <typename T, class V>
+Rle_lin_matrix<T, V>::Rle_lin_matrix(const Rcpp::RObject& in) : advanced_lin_matrix<T, V, Rle_matrix<T, V> >(in) {}
+
+template <typename T, class V>
+Rle_lin_matrix<T, V>::~Rle_lin_matrix() {} 
+
+template <typename T, class V>
+void Rle_lin_matrix<T, V>::get_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    this->mat.get_row(r, out, first, last, cur);
+    return;
+}
+
+template <typename T, class V>
+void Rle_lin_matrix<T, V>::get_row(size_t r, Rcpp::NumericVector::iterator out, size_t first, size_t last, row_cursor& cur) {
+    this->mat.get_row(r, out, first, last, cur);
+    return;
+}
+
+template <typename T, class V>
+void Rle_lin_matrix<T, V>::get_row(size_t r, float* out, size_t first, size_t last, row_cursor& cur) {
+    this->mat.get_row(r, out, first, last, cur);
+    return;
+}
+
+template <typename T, class V>
+std::unique_ptr<lin_matrix<T, V> > Rle_lin_matrix<T, V>::clone() const {
+    return std::unique_ptr<lin_matrix<T, V> >(new Rle_lin_matrix<T, V>(*this));
+}
+
 /* Defining the HDF5 interface. */
 
 template<typename T, class V, int RTYPE>
-HDF5_lin_matrix<T, V, RTYPE>::HDF5_lin_matrix(const Rcpp::RObject& incoming) : mat(incoming) {}
+HDF5_lin_matrix<T, V, RTYPE>::HDF5_lin_matrix(const Rcpp::RObject& incoming, size_t cache_size, bool prefetch, bool shared_cache, 
+        size_t threads) : mat(incoming, cache_size, prefetch, shared_cache, threads) {}
 
 template<typename T, class V, int RTYPE>
 HDF5_lin_matrix<T, V, RTYPE>::~HDF5_lin_matrix() {}
@@ -269,6 +667,30 @@ void HDF5_lin_matrix<T, V, RTYPE>::get_col(size_t c, Rcpp::NumericVector::iterat
     return;
 }
 
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_col(size_t c, float* out, size_t first, size_t last) {
+    mat.extract_col(c, &(*out), H5::PredType::NATIVE_FLOAT, first, last);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_cols(size_t first_col, size_t last_col, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
+    mat.extract_cols(first_col, last_col, &(*out), H5::PredType::NATIVE_INT32, first, last);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_cols(size_t first_col, size_t last_col, Rcpp::NumericVector::iterator out, size_t first, size_t last) {
+    mat.extract_cols(first_col, last_col, &(*out), H5::PredType::NATIVE_DOUBLE, first, last);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_cols(size_t first_col, size_t last_col, float* out, size_t first, size_t last) {
+    mat.extract_cols(first_col, last_col, &(*out), H5::PredType::NATIVE_FLOAT, first, last);
+    return;
+}
+
 template<typename T, class V, int RTYPE>
 void HDF5_lin_matrix<T, V, RTYPE>::get_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.extract_row(r, &(*out), H5::PredType::NATIVE_INT32, first, last);
@@ -281,6 +703,48 @@ void HDF5_lin_matrix<T, V, RTYPE>::get_row(size_t r, Rcpp::NumericVector::iterat
     return;
 }
 
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_row(size_t r, float* out, size_t first, size_t last) {
+    mat.extract_row(r, &(*out), H5::PredType::NATIVE_FLOAT, first, last);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::IntegerVector::iterator out) {
+    mat.extract_row_subset(r, cols, n, &(*out), H5::PredType::NATIVE_INT32);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::NumericVector::iterator out) {
+    mat.extract_row_subset(r, cols, n, &(*out), H5::PredType::NATIVE_DOUBLE);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, float* out) {
+    mat.extract_row_subset(r, cols, n, &(*out), H5::PredType::NATIVE_FLOAT);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::IntegerVector::iterator out) {
+    mat.extract_col_subset(c, rows, n, &(*out), H5::PredType::NATIVE_INT32);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::NumericVector::iterator out) {
+    mat.extract_col_subset(c, rows, n, &(*out), H5::PredType::NATIVE_DOUBLE);
+    return;
+}
+
+template<typename T, class V, int RTYPE>
+void HDF5_lin_matrix<T, V, RTYPE>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, float* out) {
+    mat.extract_col_subset(c, rows, n, &(*out), H5::PredType::NATIVE_FLOAT);
+    return;
+}
+
 template<typename T, class V, int RTYPE>
 T HDF5_lin_matrix<T, V, RTYPE>::get(size_t r, size_t c) {
     T out;
@@ -288,6 +752,18 @@ T HDF5_lin_matrix<T, V, RTYPE>::get(size_t r, size_t c) {
     return out; 
 }
 
+/* Returning a pointer into the memory-mapped file if possible, to avoid a copy. */
+
+template<typename T, class V, int RTYPE>
+typename V::const_iterator HDF5_lin_matrix<T, V, RTYPE>::get_const_col(size_t c, typename V::iterator work, size_t first, size_t last) {
+    const T* ptr=mat.get_mapped_col(c, first, last);
+    if (ptr==NULL) {
+        get_col(c, work, first, last);
+        return work;
+    }
+    return ptr;
+}
+
 template<typename T, class V, int RTYPE>
 std::unique_ptr<lin_matrix<T, V> > HDF5_lin_matrix<T, V, RTYPE>::clone() const {
     return std::unique_ptr<lin_matrix<T, V> >(new HDF5_lin_matrix<T, V, RTYPE>(*this));
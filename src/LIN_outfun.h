@@ -25,6 +25,12 @@ void lin_output<T>::get_col(size_t c, Rcpp::NumericVector::iterator out) {
     return;
 }
 
+template<typename T>
+void lin_output<T>::get_col(size_t c, float* out) {
+    get_col(c, out, 0, get_nrow());
+    return;
+}
+
 template<typename T>
 void lin_output<T>::get_row(size_t r, Rcpp::IntegerVector::iterator out) {
     get_row(r, out, 0, get_ncol());
@@ -37,6 +43,12 @@ void lin_output<T>::get_row(size_t r, Rcpp::NumericVector::iterator out) {
     return;
 }
 
+template<typename T>
+void lin_output<T>::get_row(size_t r, float* out) {
+    get_row(r, out, 0, get_ncol());
+    return;
+}
+
 template<typename T>
 void lin_output<T>::set_col(size_t c, Rcpp::IntegerVector::iterator out) {
     set_col(c, out, 0, get_nrow());
@@ -49,6 +61,12 @@ void lin_output<T>::set_col(size_t c, Rcpp::NumericVector::iterator out) {
     return;
 }
 
+template<typename T>
+void lin_output<T>::set_col(size_t c, float* out) {
+    set_col(c, out, 0, get_nrow());
+    return;
+}
+
 template<typename T>
 void lin_output<T>::set_row(size_t r, Rcpp::IntegerVector::iterator out) {
     set_row(r, out, 0, get_ncol());
@@ -61,6 +79,15 @@ void lin_output<T>::set_row(size_t r, Rcpp::NumericVector::iterator out) {
     return;
 }
 
+template<typename T>
+void lin_output<T>::set_row(size_t r, float* out) {
+    set_row(r, out, 0, get_ncol());
+    return;
+}
+
+template<typename T>
+void lin_output<T>::flush() {}
+
 /* Defining the simple output interface. */ 
 
 template<typename T, class V>
@@ -91,6 +118,12 @@ void simple_lin_output<T, V>::get_col(size_t c, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void simple_lin_output<T, V>::get_col(size_t c, float* out, size_t first, size_t last) {
+    mat.get_col(c, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 void simple_lin_output<T, V>::get_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.get_row(r, out, first, last);
@@ -103,6 +136,12 @@ void simple_lin_output<T, V>::get_row(size_t r, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void simple_lin_output<T, V>::get_row(size_t r, float* out, size_t first, size_t last) {
+    mat.get_row(r, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 T simple_lin_output<T, V>::get(size_t r, size_t c) {
     return mat.get(r, c);
@@ -120,6 +159,12 @@ void simple_lin_output<T, V>::set_col(size_t c, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void simple_lin_output<T, V>::set_col(size_t c, float* out, size_t first, size_t last) {
+    mat.set_col(c, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 void simple_lin_output<T, V>::set_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.set_row(r, out, first, last);
@@ -132,6 +177,12 @@ void simple_lin_output<T, V>::set_row(size_t r, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void simple_lin_output<T, V>::set_row(size_t r, float* out, size_t first, size_t last) {
+    mat.set_row(r, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 void simple_lin_output<T, V>::set(size_t r, size_t c, T in) {
     mat.set(r, c, in);
@@ -157,7 +208,7 @@ matrix_type simple_lin_output<T, V>::get_matrix_type() const {
 /* Defining the sparse output interface. */ 
 
 template<typename T, class V>
-sparse_lin_output<T, V>::sparse_lin_output(size_t nr, size_t nc) : mat(nr, nc) {}
+sparse_lin_output<T, V>::sparse_lin_output(size_t nr, size_t nc, size_t limit, size_t threads) : mat(nr, nc, limit, threads) {}
 
 template<typename T, class V>
 sparse_lin_output<T, V>::~sparse_lin_output() {}
@@ -184,6 +235,12 @@ void sparse_lin_output<T, V>::get_col(size_t c, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void sparse_lin_output<T, V>::get_col(size_t c, float* out, size_t first, size_t last) {
+    mat.get_col(c, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 void sparse_lin_output<T, V>::get_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.get_row(r, out, first, last);
@@ -196,6 +253,12 @@ void sparse_lin_output<T, V>::get_row(size_t r, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void sparse_lin_output<T, V>::get_row(size_t r, float* out, size_t first, size_t last) {
+    mat.get_row(r, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 T sparse_lin_output<T, V>::get(size_t r, size_t c) {
     return mat.get(r, c);
@@ -213,6 +276,12 @@ void sparse_lin_output<T, V>::set_col(size_t c, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void sparse_lin_output<T, V>::set_col(size_t c, float* out, size_t first, size_t last) {
+    mat.set_col(c, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 void sparse_lin_output<T, V>::set_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.set_row(r, out, first, last);
@@ -225,12 +294,24 @@ void sparse_lin_output<T, V>::set_row(size_t r, Rcpp::NumericVector::iterator ou
     return;
 }
 
+template<typename T, class V>
+void sparse_lin_output<T, V>::set_row(size_t r, float* out, size_t first, size_t last) {
+    mat.set_row(r, out, first, last);
+    return;
+}
+
 template<typename T, class V>
 void sparse_lin_output<T, V>::set(size_t r, size_t c, T in) {
     mat.set(r, c, in);
     return;
 }
 
+template<typename T, class V>
+void sparse_lin_output<T, V>::flush() {
+    mat.finalize();
+    return;
+}
+
 template<typename T, class V>
 Rcpp::RObject sparse_lin_output<T, V>::yield() {
     return mat.yield();
@@ -249,8 +330,8 @@ matrix_type sparse_lin_output<T, V>::get_matrix_type() const {
 /* Defining the HDF5 output interface. */
 
 template<typename T, int RTYPE>
-HDF5_lin_output<T, RTYPE>::HDF5_lin_output(size_t nr, size_t nc, size_t chunk_nr, size_t chunk_nc, int compress) : 
-    mat(nr, nc, chunk_nr, chunk_nc, compress) {}
+HDF5_lin_output<T, RTYPE>::HDF5_lin_output(size_t nr, size_t nc, size_t chunk_nr, size_t chunk_nc, int compress, size_t cache_size, 
+        size_t threads, storage_type storage) : mat(nr, nc, chunk_nr, chunk_nc, compress, output_param::DEFAULT_STRLEN, cache_size, threads, storage) {}
 
 template<typename T, int RTYPE>
 HDF5_lin_output<T, RTYPE>::~HDF5_lin_output() {}
@@ -290,6 +371,12 @@ void HDF5_lin_output<T, RTYPE>::get_row(size_t r, Rcpp::NumericVector::iterator
     return;
 }
 
+template<typename T, int RTYPE>
+void HDF5_lin_output<T, RTYPE>::get_row(size_t r, float* out, size_t first, size_t last) {
+    mat.extract_row(r, &(*out), H5::PredType::NATIVE_FLOAT, first, last);
+    return;
+}
+
 template<typename T, int RTYPE>
 void HDF5_lin_output<T, RTYPE>::get_col(size_t c, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.extract_col(c, &(*out), H5::PredType::NATIVE_INT32, first, last);
@@ -302,6 +389,12 @@ void HDF5_lin_output<T, RTYPE>::get_col(size_t c, Rcpp::NumericVector::iterator
     return;
 }
 
+template<typename T, int RTYPE>
+void HDF5_lin_output<T, RTYPE>::get_col(size_t c, float* out, size_t first, size_t last) {
+    mat.extract_col(c, &(*out), H5::PredType::NATIVE_FLOAT, first, last);
+    return;
+}
+
 template<typename T, int RTYPE>
 void HDF5_lin_output<T, RTYPE>::set_row(size_t r, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.insert_row(r, &(*out), H5::PredType::NATIVE_INT32, first, last);
@@ -314,6 +407,12 @@ void HDF5_lin_output<T, RTYPE>::set_row(size_t r, Rcpp::NumericVector::iterator
     return;
 }
 
+template<typename T, int RTYPE>
+void HDF5_lin_output<T, RTYPE>::set_row(size_t r, float* out, size_t first, size_t last) {
+    mat.insert_row(r, &(*out), H5::PredType::NATIVE_FLOAT, first, last);
+    return;
+}
+
 template<typename T, int RTYPE>
 void HDF5_lin_output<T, RTYPE>::set_col(size_t c, Rcpp::IntegerVector::iterator out, size_t first, size_t last) {
     mat.insert_col(c, &(*out), H5::PredType::NATIVE_INT32, first, last);
@@ -326,6 +425,18 @@ void HDF5_lin_output<T, RTYPE>::set_col(size_t c, Rcpp::NumericVector::iterator
     return;
 }
 
+template<typename T, int RTYPE>
+void HDF5_lin_output<T, RTYPE>::set_col(size_t c, float* out, size_t first, size_t last) {
+    mat.insert_col(c, &(*out), H5::PredType::NATIVE_FLOAT, first, last);
+    return;
+}
+
+template<typename T, int RTYPE>
+void HDF5_lin_output<T, RTYPE>::flush() {
+    mat.flush();
+    return;
+}
+
 template<typename T, int RTYPE>
 Rcpp::RObject HDF5_lin_output<T, RTYPE>::yield() {
     return mat.yield();
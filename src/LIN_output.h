@@ -21,32 +21,42 @@ public:
 
     void get_row(size_t, Rcpp::IntegerVector::iterator);
     void get_row(size_t, Rcpp::NumericVector::iterator);
+    void get_row(size_t, float*);
 
     virtual void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t)=0;
     virtual void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t)=0;
+    virtual void get_row(size_t, float*, size_t, size_t)=0;
 
     void get_col(size_t, Rcpp::IntegerVector::iterator);
     void get_col(size_t, Rcpp::NumericVector::iterator);
+    void get_col(size_t, float*);
 
     virtual void get_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t)=0;
     virtual void get_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t)=0;
+    virtual void get_col(size_t, float*, size_t, size_t)=0;
 
     virtual T get(size_t, size_t)=0;
 
     void set_row(size_t, Rcpp::IntegerVector::iterator);
     void set_row(size_t, Rcpp::NumericVector::iterator);
+    void set_row(size_t, float*);
 
     virtual void set_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t)=0;
     virtual void set_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t)=0;
+    virtual void set_row(size_t, float*, size_t, size_t)=0;
 
     void set_col(size_t, Rcpp::IntegerVector::iterator);
     void set_col(size_t, Rcpp::NumericVector::iterator);
+    void set_col(size_t, float*);
 
     virtual void set_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t)=0;
     virtual void set_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t)=0;
+    virtual void set_col(size_t, float*, size_t, size_t)=0;
 
     virtual void set(size_t, size_t, T)=0;
 
+    virtual void flush(); // Writes any buffered values to the underlying storage.
+
     virtual Rcpp::RObject yield()=0;
 
     virtual std::unique_ptr<lin_output<T> > clone() const=0;
@@ -67,17 +77,21 @@ public:
 
     void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_row(size_t, float*, size_t, size_t);
 
     void get_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_col(size_t, float*, size_t, size_t);
 
     T get(size_t, size_t);
 
     void set_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void set_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void set_row(size_t, float*, size_t, size_t);
 
     void set_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void set_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void set_col(size_t, float*, size_t, size_t);
 
     void set(size_t, size_t, T);
 
@@ -95,7 +109,9 @@ private:
 template<typename T, class V>
 class sparse_lin_output : public lin_output<T> {
 public:
-    sparse_lin_output(size_t, size_t);
+    sparse_lin_output(size_t, size_t, 
+            size_t=output_param::DEFAULT_MEMORY_LIMIT,
+            size_t=output_param::DEFAULT_THREADS);
     ~sparse_lin_output();
 
     size_t get_nrow() const;
@@ -103,20 +119,26 @@ public:
 
     void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_row(size_t, float*, size_t, size_t);
 
     void get_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_col(size_t, float*, size_t, size_t);
 
     T get(size_t, size_t);
 
     void set_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void set_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void set_row(size_t, float*, size_t, size_t);
 
     void set_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void set_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void set_col(size_t, float*, size_t, size_t);
 
     void set(size_t, size_t, T);
 
+    void flush();
+
     Rcpp::RObject yield();
 
     std::unique_ptr<lin_output<T> > clone() const;
@@ -134,7 +156,10 @@ public:
     HDF5_lin_output(size_t, size_t, 
             size_t=output_param::DEFAULT_CHUNKDIM, 
             size_t=output_param::DEFAULT_CHUNKDIM, 
-            int=output_param::DEFAULT_COMPRESS);
+            int=output_param::DEFAULT_COMPRESS,
+            size_t=output_param::DEFAULT_CACHE_SIZE,
+            size_t=output_param::DEFAULT_THREADS,
+            storage_type=output_param::DEFAULT_STORAGE_TYPE);
     ~HDF5_lin_output();
 
     size_t get_nrow() const;
@@ -142,20 +167,26 @@ public:
 
     void get_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_row(size_t, float*, size_t, size_t);
 
     void get_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void get_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void get_col(size_t, float*, size_t, size_t);
 
     T get(size_t, size_t);
 
     void set_row(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void set_row(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void set_row(size_t, float*, size_t, size_t);
 
     void set_col(size_t, Rcpp::IntegerVector::iterator, size_t, size_t);
     void set_col(size_t, Rcpp::NumericVector::iterator, size_t, size_t);
+    void set_col(size_t, float*, size_t, size_t);
 
     void set(size_t, size_t, T);
 
+    void flush();
+
     Rcpp::RObject yield();
 
     std::unique_ptr<lin_output<T> > clone() const;
@@ -23,6 +23,15 @@ public:
     template <class Iter>
     void get_col(size_t, Iter, size_t, size_t);
 
+    template <class Iter>
+    void get_cols(size_t, size_t, Iter, size_t, size_t);
+
+    template <class Iter>
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
+    template <class Iter>
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
     Rcpp::RObject yield () const;
     matrix_type get_matrix_type () const;
 protected:
@@ -102,7 +111,7 @@ size_t Psymm_matrix<T, V>::get_index(size_t r, size_t c) const {
 
 template <typename T, class V>
 T Psymm_matrix<T, V>::get(size_t r, size_t c) {
-    return x[get_index(r, c)];
+    return *(x.begin() + get_index(r, c));
 }
 
 template <typename T, class V>
@@ -162,6 +171,17 @@ void Psymm_matrix<T, V>::get_col (size_t c, Iter out, size_t first, size_t last)
     return;
 }
 
+template <typename T, class V>
+template <class Iter>
+void Psymm_matrix<T, V>::get_cols (size_t first_col, size_t last_col, Iter out, size_t first, size_t last) {
+    check_colsargs(first_col, last_col, first, last);
+    const size_t nvals=last-first;
+    for (size_t c=first_col; c<last_col; ++c, out+=nvals) {
+        get_rowcol(c, out, first, last);
+    }
+    return;
+}
+
 template <typename T, class V>
 template <class Iter>
 void Psymm_matrix<T, V>::get_row (size_t r, Iter out, size_t first, size_t last) {
@@ -170,6 +190,26 @@ void Psymm_matrix<T, V>::get_row (size_t r, Iter out, size_t first, size_t last)
     return;
 }
 
+template <typename T, class V>
+template <class Iter>
+void Psymm_matrix<T, V>::get_col_subset (size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Iter out) {
+    check_colsubset(c, rows, n);
+    for (size_t i=0; i<n; ++i, ++rows, ++out) {
+        (*out)=*(x.begin() + get_index(*rows, c));
+    }
+    return;
+}
+
+template <typename T, class V>
+template <class Iter>
+void Psymm_matrix<T, V>::get_row_subset (size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Iter out) {
+    check_rowsubset(r, cols, n);
+    for (size_t i=0; i<n; ++i, ++cols, ++out) {
+        (*out)=*(x.begin() + get_index(r, *cols));
+    }
+    return;
+}
+
 template<typename T, class V>
 Rcpp::RObject Psymm_matrix<T, V>::yield () const {
     return original;
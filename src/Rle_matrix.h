@@ -20,9 +20,21 @@ public:
     template<class Iter>
     void get_row(size_t, Iter, size_t, size_t); 
 
+    template<class Iter>
+    void get_row(size_t, Iter, size_t, size_t, row_cursor&); 
+
     template<class Iter>
     void get_col(size_t, Iter, size_t, size_t); 
 
+    template<class Iter>
+    void get_cols(size_t, size_t, Iter, size_t, size_t); 
+
+    template<class Iter>
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
+    template<class Iter>
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
     Rcpp::RObject yield() const;
     matrix_type get_matrix_type () const;
 private:
@@ -36,9 +48,8 @@ private:
     void initialize_chunked_rle(const Rcpp::RObject&);
     size_t parse_rle(const Rcpp::IntegerVector&, size_t);
 
-    size_t cache_row, cache_start, cache_end;
-    std::vector<size_t> cache_indices;
-    void update_indices(size_t r, size_t first, size_t last);
+    row_cursor cursor; // Used when no cursor is supplied by the caller.
+    void update_indices(size_t, size_t, size_t, row_cursor&);
 };
 
 /*** Constructor definitions ***/
@@ -75,12 +86,6 @@ Rle_matrix<T, V>::Rle_matrix(const Rcpp::RObject& incoming) : original(incoming)
     } else if (stype=="ChunkedRleArraySeed") {
         initialize_chunked_rle(rle_seed);
     }  
-  
-    // Setting up the cached indices.
-    cache_row=0;
-    cache_start=0;
-    cache_end=0;
-    cache_indices.resize(this->ncol);
     return;
 }
 
@@ -246,64 +251,111 @@ void Rle_matrix<T, V>::get_col(size_t c, Iter out, size_t first, size_t last) {
 }
 
 template<typename T, class V>
-void Rle_matrix<T, V>::update_indices(size_t r, size_t first, size_t last) {
-    if (cache_start!=first|| cache_end!=last) {
-        // Regenerate if they don't match; too much effort to keep track of which ones are valid.
-        cache_start=first;
-        cache_end=last;
-        std::fill(cache_indices.begin() + first, cache_indices.begin() + last, 0);
-        cache_row=0;
+template<class Iter>
+void Rle_matrix<T, V>::get_cols(size_t first_col, size_t last_col, Iter out, size_t first, size_t last) {
+    check_colsargs(first_col, last_col, first, last);
+    const size_t nvals=last-first;
+    for (size_t c=first_col; c<last_col; ++c, out+=nvals) {
+        get_col(c, out, first, last);
+    }
+    return;
+}
+
+template<typename T, class V>
+void Rle_matrix<T, V>::update_indices(size_t r, size_t first, size_t last, row_cursor& cur) {
+    if (!cur.matches(first, last, cumrow.data(), cumrow.size())) {
+        // Regenerate if they don't match (or are from another matrix); too much effort to keep track of which ones are valid.
+        cur.reset(first, last, cumrow.data(), cumrow.size());
+        std::fill(cur.indices.begin(), cur.indices.end(), 0);
     }
 
     /* Index for column 'c' should hold the point at cumrow[c] that is greater than 'r'.
      * We use an upper bound because a cumulative row of 1 corresponds to a row index of 0.
+     * Note that the cursor indices only span the slice, so they are offset by 'first'.
      */
-    if (r==cache_row) {
+    if (r==cur.row) {
         return;
     }
-    if (r==cache_row+1) {
-        for (size_t c=first; c<last; ++c) {
-            size_t& curIndex=cache_indices[c];
+    auto cIt=cur.indices.begin();
+    if (r==cur.row+1) {
+        for (size_t c=first; c<last; ++c, ++cIt) {
+            size_t& curIndex=*cIt;
             if (cumrow[c][curIndex] <= r) {
                 ++curIndex;
             }            
         }        
-    } else if (r+1==cache_row) {
-        for (size_t c=first; c<last; ++c) {
-            size_t& curIndex=cache_indices[c];
+    } else if (r+1==cur.row) {
+        for (size_t c=first; c<last; ++c, ++cIt) {
+            size_t& curIndex=*cIt;
             if (curIndex) {
                 if (cumrow[c][curIndex-1] > r) {
                     --curIndex;
                 }
             }        
         }
-    } else if (r > cache_row) {
-        for (size_t c=first; c<last; ++c) {
+    } else if (r > cur.row) {
+        for (size_t c=first; c<last; ++c, ++cIt) {
             const auto& curcol=cumrow[c];
-            size_t& curIndex=cache_indices[c];
+            size_t& curIndex=*cIt;
             auto rdIt=std::upper_bound(curcol.begin() + curIndex, curcol.end(), r);
             curIndex=rdIt - curcol.begin();            
         }
-    } else if (r < cache_row) {
-        for (size_t c=first; c<last; ++c) {
+    } else if (r < cur.row) {
+        for (size_t c=first; c<last; ++c, ++cIt) {
             const auto& curcol=cumrow[c];
-            size_t& curIndex=cache_indices[c];
+            size_t& curIndex=*cIt;
             auto rdIt=std::upper_bound(curcol.begin(), curcol.begin() + curIndex, r);
             curIndex=rdIt - curcol.begin();            
         }
     }
 
-    cache_row=r;
+    cur.row=r;
     return;
 }
 
 template<typename T, class V>
 template<class Iter>
 void Rle_matrix<T, V>::get_row(size_t r, Iter out, size_t first, size_t last) {
+    get_row(r, out, first, last, cursor);
+    return;
+}
+
+template<typename T, class V>
+template<class Iter>
+void Rle_matrix<T, V>::get_row(size_t r, Iter out, size_t first, size_t last, row_cursor& cur) {
     check_rowargs(r, first, last);
-    update_indices(r, first, last);
-    for (size_t c=first; c<last; ++c, ++out) {
-        (*out)=*(runvalues[chunkdex[c]].begin() + cache_indices[c] + coldex[c]);
+    update_indices(r, first, last, cur);
+    auto cIt=cur.indices.begin();
+    for (size_t c=first; c<last; ++c, ++cIt, ++out) {
+        (*out)=*(runvalues[chunkdex[c]].begin() + (*cIt) + coldex[c]);
+    }
+    return;
+}
+
+template<typename T, class V>
+template<class Iter>
+void Rle_matrix<T, V>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Iter out) {
+    check_colsubset(c, rows, n);
+
+    // Walking through the cumulative rows once, as the requested rows are sorted.
+    const auto& curcol=cumrow[c];
+    auto rvstart=runvalues[chunkdex[c]].begin() + coldex[c];
+    auto ccstart=curcol.begin(), ccIt=ccstart;
+    for (size_t i=0; i<n; ++i, ++rows, ++out) {
+        ccIt=gallop_upper_bound(ccIt, curcol.end(), size_t(*rows));
+        (*out)=*(rvstart + (ccIt - ccstart));
+    }
+    return;
+}
+
+template<typename T, class V>
+template<class Iter>
+void Rle_matrix<T, V>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Iter out) {
+    check_rowsubset(r, cols, n);
+    for (size_t i=0; i<n; ++i, ++cols, ++out) {
+        const auto& curcol=cumrow[*cols];
+        size_t extra=std::upper_bound(curcol.begin(), curcol.end(), r) - curcol.begin();
+        (*out)=*(runvalues[chunkdex[*cols]].begin() + coldex[*cols] + extra);
     }
     return;
 }
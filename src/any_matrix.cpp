@@ -1,7 +1,25 @@
 #include "any_matrix.h"
+#include "utils.h"
 
 namespace beachmat { 
 
+row_cursor::row_cursor() : row(0), first(0), last(0), initialized(false), owner(NULL), owner_size(0) {}
+
+void row_cursor::reset(size_t f, size_t l, const void* o, size_t n) {
+    row=0;
+    first=f;
+    last=l;
+    indices.resize(l-f);
+    initialized=true;
+    owner=o;
+    owner_size=n;
+    return;
+}
+
+bool row_cursor::matches(size_t f, size_t l, const void* o, size_t n) const {
+    return initialized && first==f && last==l && owner==o && owner_size==n;
+}
+
 any_matrix::any_matrix() : nrow(0), ncol(0) {}
 
 any_matrix::any_matrix(size_t nr, size_t nc) : nrow(nr), ncol(nc) {}
@@ -45,6 +63,19 @@ void any_matrix::check_colargs(size_t c, size_t first, size_t last) const {
     return;
 }
 
+void any_matrix::check_colsargs(size_t first_col, size_t last_col, size_t first, size_t last) const {
+    if (last_col < first_col) {
+        throw std::runtime_error("column start index is greater than column end index");
+    } else if (last_col > ncol) {
+        throw std::runtime_error("column end index out of range");
+    } else if (last < first) {
+        throw std::runtime_error("row start index is greater than row end index");
+    } else if (last > nrow) {
+        throw std::runtime_error("row end index out of range");
+    }
+    return;
+}
+
 void any_matrix::check_oneargs(size_t r, size_t c) const {
     if (c>=ncol || r>=nrow) {
         throw std::runtime_error("column or row indices out of range");
@@ -52,4 +83,38 @@ void any_matrix::check_oneargs(size_t r, size_t c) const {
     return;
 }
 
+/* These functions check that subset indices are sorted, unique and within range,
+ * which allows the backends to exploit sortedness when extracting values.
+ */
+
+void check_subset_indices(Rcpp::IntegerVector::const_iterator indices, size_t n, size_t dim, const std::string& type) {
+    int last=-1;
+    for (size_t i=0; i<n; ++i, ++indices) {
+        const int& current=*indices;
+        if (current < 0 || current >= int(dim)) {
+            throw_custom_error("", type, " subset indices out of range");
+        } else if (current <= last) {
+            throw_custom_error("", type, " subset indices should be sorted and unique");
+        }
+        last=current;
+    }
+    return;
+}
+
+void any_matrix::check_rowsubset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n) const {
+    if (r>=nrow) {
+        throw std::runtime_error("row index out of range");
+    }
+    check_subset_indices(cols, n, ncol, "column");
+    return;
+}
+
+void any_matrix::check_colsubset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n) const {
+    if (c>=ncol) {
+        throw std::runtime_error("column index out of range");
+    }
+    check_subset_indices(rows, n, nrow, "row");
+    return;
+}
+
 }
@@ -7,6 +7,25 @@
 
 namespace beachmat{
 
+/* Cursor for sequential row access, storing the current position in each column of a row slice.
+ * Separate cursors can be created for each slice (or thread) to avoid resetting each other's positions.
+ * The cursor also records the data that it was built on (and their size), and is reset if it is
+ * used with a different matrix, as the stored positions would not be valid for that matrix.
+ */
+
+class row_cursor {
+public:
+    row_cursor();
+    void reset(size_t, size_t, const void* =NULL, size_t=0);
+    bool matches(size_t, size_t, const void*, size_t) const;
+    size_t row, first, last;
+    bool initialized;
+    std::vector<size_t> indices;
+private:
+    const void* owner;
+    size_t owner_size;
+};
+
 class any_matrix {
 public:
     any_matrix();
@@ -19,7 +38,10 @@ protected:
     void fill_dims(const Rcpp::RObject&);
     void check_rowargs(size_t, size_t, size_t) const;
     void check_colargs(size_t, size_t, size_t) const;
+    void check_colsargs(size_t, size_t, size_t, size_t) const;
     void check_oneargs(size_t, size_t) const;
+    void check_rowsubset(size_t, Rcpp::IntegerVector::const_iterator, size_t) const;
+    void check_colsubset(size_t, Rcpp::IntegerVector::const_iterator, size_t) const;
 };
 
 }
@@ -3,12 +3,25 @@
 
 #include <vector>
 #include <deque>
+#include <list>
+#include <map>
+#include <tuple>
 #include <algorithm>
+#include <numeric>
 #include <string>
 #include <memory>
 #include <stdexcept>
 #include <sstream>
 #include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <type_traits>
 
 #include "Rcpp.h"
 #include "R.h"
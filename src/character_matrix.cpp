@@ -16,6 +16,26 @@ void character_matrix::get_row(size_t r, Rcpp::StringVector::iterator out) {
     get_row(r, out, 0, get_ncol());
 }
 
+void character_matrix::get_row(size_t r, Rcpp::StringVector::iterator out, row_cursor& cur) { 
+    get_row(r, out, 0, get_ncol(), cur);
+}
+
+void character_matrix::get_row(size_t r, Rcpp::StringVector::iterator out, size_t first, size_t last, row_cursor& cur) { 
+    get_row(r, out, first, last); // Cursors are ignored by default.
+}
+
+void character_matrix::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::StringVector::iterator out) { 
+    for (size_t i=0; i<n; ++i, ++cols, ++out) {
+        (*out)=get(r, *cols);
+    }
+}
+
+void character_matrix::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::StringVector::iterator out) { 
+    for (size_t i=0; i<n; ++i, ++rows, ++out) {
+        (*out)=get(*rows, c);
+    }
+}
+
 Rcpp::StringVector::iterator character_matrix::get_const_col(size_t c, Rcpp::StringVector::iterator work) {
     return get_const_col(c, work, 0, get_nrow());
 }
@@ -47,6 +67,14 @@ void simple_character_matrix::get_col(size_t c, Rcpp::StringVector::iterator out
     mat.get_col(c, out, first, last);
 }
 
+void simple_character_matrix::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::StringVector::iterator out) { 
+    mat.get_row_subset(r, cols, n, out);
+}
+
+void simple_character_matrix::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::StringVector::iterator out) { 
+    mat.get_col_subset(c, rows, n, out);
+}
+
 Rcpp::String simple_character_matrix::get(size_t r, size_t c) {
     return mat.get(r, c);
 }
@@ -85,10 +113,22 @@ void Rle_character_matrix::get_row(size_t r, Rcpp::StringVector::iterator out, s
     mat.get_row(r, out, first, last);
 }
 
+void Rle_character_matrix::get_row(size_t r, Rcpp::StringVector::iterator out, size_t first, size_t last, row_cursor& cur) { 
+    mat.get_row(r, out, first, last, cur);
+}
+
 void Rle_character_matrix::get_col(size_t c, Rcpp::StringVector::iterator out, size_t first, size_t last) { 
     mat.get_col(c, out, first, last);
 }
 
+void Rle_character_matrix::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::StringVector::iterator out) { 
+    mat.get_row_subset(r, cols, n, out);
+}
+
+void Rle_character_matrix::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::StringVector::iterator out) { 
+    mat.get_col_subset(c, rows, n, out);
+}
+
 Rcpp::String Rle_character_matrix::get(size_t r, size_t c) {
     return mat.get(r, c);
 }
@@ -107,7 +147,9 @@ matrix_type Rle_character_matrix::get_matrix_type() const {
 
 /* Methods for the HDF5 character matrix. */
 
-HDF5_character_matrix::HDF5_character_matrix(const Rcpp::RObject& incoming) : mat(incoming) {
+HDF5_character_matrix::HDF5_character_matrix(const Rcpp::RObject& incoming, size_t cache_size, bool prefetch, bool shared_cache, 
+        size_t threads) : mat(incoming, cache_size, prefetch, shared_cache, threads) {
+    std::lock_guard<std::mutex> lock(get_HDF5_mutex());
     const H5::DataType& str_type=mat.get_datatype();
     if (!str_type.isVariableStr()) { 
         bufsize=str_type.getSize(); 
@@ -147,6 +189,26 @@ void HDF5_character_matrix::get_col(size_t c, Rcpp::StringVector::iterator out,
     return;
 }
  
+/* Subset indices are unique, so the existing row/column buffers are always large enough. */
+
+void HDF5_character_matrix::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Rcpp::StringVector::iterator out) { 
+    char* ref=row_buf.data();
+    mat.extract_row_subset(r, cols, n, ref);
+    for (size_t i=0; i<n; ++i, ref+=bufsize, ++out) {
+        (*out)=ref; 
+    }
+    return;
+} 
+
+void HDF5_character_matrix::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Rcpp::StringVector::iterator out) { 
+    char* ref=col_buf.data();
+    mat.extract_col_subset(c, rows, n, ref);
+    for (size_t i=0; i<n; ++i, ref+=bufsize, ++out) {
+        (*out)=ref; 
+    }
+    return;
+}
+ 
 Rcpp::String HDF5_character_matrix::get(size_t r, size_t c) { 
     char* ref=one_buf.data();
     mat.extract_one(r, c, ref);
@@ -168,17 +230,22 @@ matrix_type HDF5_character_matrix::get_matrix_type() const {
 /* Dispatch definition */
 
 std::unique_ptr<character_matrix> create_character_matrix(const Rcpp::RObject& incoming) { 
+    return create_character_matrix(incoming, input_param());
+}
+
+std::unique_ptr<character_matrix> create_character_matrix(const Rcpp::RObject& incoming, const input_param& param) { 
     if (incoming.isS4()) { 
         std::string ctype=get_class(incoming);
         if (ctype=="HDF5Matrix") {
-            return std::unique_ptr<character_matrix>(new HDF5_character_matrix(incoming));
+            return std::unique_ptr<character_matrix>(new HDF5_character_matrix(incoming, 
+                        param.get_cache_size(), param.get_prefetch(), param.get_shared_cache(), param.get_threads()));
         } else if (ctype=="RleMatrix") { 
             return std::unique_ptr<character_matrix>(new Rle_character_matrix(incoming));
         } else if (ctype=="DelayedMatrix") { 
             if (is_pristine_delayed_array(incoming)) { 
-                return create_character_matrix(get_safe_slot(incoming, "seed"));
+                return create_character_matrix(get_safe_slot(incoming, "seed"), param);
             } else {
-                return create_character_matrix(realize_delayed_array(incoming));
+                return create_character_matrix(realize_delayed_array(incoming), param);
             }
         }
         std::stringstream err;
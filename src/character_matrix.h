@@ -18,9 +18,15 @@ public:
     void get_row(size_t, Rcpp::StringVector::iterator); 
     virtual void get_row(size_t, Rcpp::StringVector::iterator, size_t, size_t)=0;
 
+    void get_row(size_t, Rcpp::StringVector::iterator, row_cursor&); 
+    virtual void get_row(size_t, Rcpp::StringVector::iterator, size_t, size_t, row_cursor&);
+
     void get_col(size_t, Rcpp::StringVector::iterator);
     virtual void get_col(size_t, Rcpp::StringVector::iterator, size_t, size_t)=0;
 
+    virtual void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+    virtual void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+
     virtual Rcpp::String get(size_t, size_t)=0;
 
     Rcpp::StringVector::iterator get_const_col(size_t, Rcpp::StringVector::iterator);
@@ -45,6 +51,9 @@ public:
     void get_row(size_t, Rcpp::StringVector::iterator, size_t, size_t);
     void get_col(size_t, Rcpp::StringVector::iterator, size_t, size_t);
 
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+
     Rcpp::String get(size_t, size_t);
 
     Rcpp::StringVector::iterator get_const_col(size_t, Rcpp::StringVector::iterator, size_t, size_t);
@@ -68,8 +77,12 @@ public:
     size_t get_ncol() const;
  
     void get_row(size_t, Rcpp::StringVector::iterator, size_t, size_t);
+    void get_row(size_t, Rcpp::StringVector::iterator, size_t, size_t, row_cursor&);
     void get_col(size_t, Rcpp::StringVector::iterator, size_t, size_t);
 
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+
     Rcpp::String get(size_t, size_t);
 
     std::unique_ptr<character_matrix> clone() const;
@@ -84,7 +97,8 @@ private:
 
 class HDF5_character_matrix : public character_matrix {
 public:    
-    HDF5_character_matrix(const Rcpp::RObject&);
+    HDF5_character_matrix(const Rcpp::RObject&, size_t=input_param::DEFAULT_CACHE_SIZE, bool=input_param::DEFAULT_PREFETCH, 
+            bool=input_param::DEFAULT_SHARED_CACHE, size_t=input_param::DEFAULT_THREADS);
     ~HDF5_character_matrix();
 
     size_t get_nrow() const;
@@ -93,6 +107,9 @@ public:
     void get_row(size_t, Rcpp::StringVector::iterator, size_t, size_t);
     void get_col(size_t, Rcpp::StringVector::iterator, size_t, size_t);
 
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Rcpp::StringVector::iterator);
+
     Rcpp::String get(size_t, size_t);
 
     std::unique_ptr<character_matrix> clone() const;
@@ -109,6 +126,8 @@ protected:
 
 std::unique_ptr<character_matrix> create_character_matrix(const Rcpp::RObject&);
 
+std::unique_ptr<character_matrix> create_character_matrix(const Rcpp::RObject&, const input_param&);
+
 }
 
 /* Collected output definitions, so people only have to do #include "character_matrix.h" */
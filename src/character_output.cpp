@@ -24,6 +24,8 @@ void character_output::set_row(size_t r, Rcpp::StringVector::iterator out) {
     set_row(r, out, 0, get_ncol());
 }
 
+void character_output::flush() {}
+
 /* Methods for the simple character matrix. */
 
 simple_character_output::simple_character_output(size_t nr, size_t nc) : mat(nr, nc) {}
@@ -89,8 +91,8 @@ Rcpp::RObject HDF5_output<char, STRSXP>::get_firstval() {
 
 /* Methods for the HDF5 character matrix. */
 
-HDF5_character_output::HDF5_character_output(size_t nr, size_t nc, size_t strlen, size_t chunk_nr, size_t chunk_nc, int compress) :
-        bufsize(strlen+1), mat(nr, nc, chunk_nr, chunk_nc, compress, bufsize), 
+HDF5_character_output::HDF5_character_output(size_t nr, size_t nc, size_t strlen, size_t chunk_nr, size_t chunk_nc, int compress, size_t cache_size, 
+        size_t threads) : bufsize(strlen+1), mat(nr, nc, chunk_nr, chunk_nc, compress, bufsize, cache_size, threads), 
         row_buf(bufsize*nc), col_buf(bufsize*nr), one_buf(bufsize) {}
 
 HDF5_character_output::~HDF5_character_output() {}
@@ -159,6 +161,11 @@ void HDF5_character_output::set(size_t r, size_t c, Rcpp::String in) {
     return;
 }
 
+void HDF5_character_output::flush() {
+    mat.flush();
+    return;
+}
+
 Rcpp::RObject HDF5_character_output::yield() {
     return mat.yield();
 }
@@ -179,7 +186,7 @@ std::unique_ptr<character_output> create_character_output(int nrow, int ncol, co
             return std::unique_ptr<character_output>(new simple_character_output(nrow, ncol));
         case HDF5:
             return std::unique_ptr<character_output>(new HDF5_character_output(nrow, ncol,
-                        param.get_strlen(), param.get_chunk_nrow(), param.get_chunk_ncol(), param.get_compression()));
+                        param.get_strlen(), param.get_chunk_nrow(), param.get_chunk_ncol(), param.get_compression(), param.get_cache_size(), param.get_threads()));
         default:
             throw std::runtime_error("unsupported output mode for character matrices");
     }
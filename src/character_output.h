@@ -35,6 +35,8 @@ public:
     virtual void set(size_t, size_t, Rcpp::String)=0;
 
     // Other stuff.
+    virtual void flush(); // Writes any buffered values to the underlying storage.
+
     virtual Rcpp::RObject yield()=0;
 
     virtual std::unique_ptr<character_output> clone() const=0;
@@ -79,7 +81,9 @@ public:
             size_t=output_param::DEFAULT_STRLEN, 
             size_t=output_param::DEFAULT_CHUNKDIM, 
             size_t=output_param::DEFAULT_CHUNKDIM, 
-            int=output_param::DEFAULT_COMPRESS);
+            int=output_param::DEFAULT_COMPRESS,
+            size_t=output_param::DEFAULT_CACHE_SIZE,
+            size_t=output_param::DEFAULT_THREADS);
     ~HDF5_character_output();
 
     size_t get_nrow() const;
@@ -95,6 +99,8 @@ public:
 
     void set(size_t, size_t, Rcpp::String);
 
+    void flush();
+
     Rcpp::RObject yield();
 
     std::unique_ptr<character_output> clone() const;
@@ -23,6 +23,15 @@ public:
     template <class Iter>
     void get_col(size_t, Iter, size_t, size_t);
 
+    template <class Iter>
+    void get_cols(size_t, size_t, Iter, size_t, size_t);
+
+    template <class Iter>
+    void get_col_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
+    template <class Iter>
+    void get_row_subset(size_t, Rcpp::IntegerVector::const_iterator, size_t, Iter);
+
     typename V::iterator get_const_col(size_t, typename V::iterator, size_t, size_t);
 
     Rcpp::RObject yield() const;
@@ -61,7 +70,7 @@ dense_matrix<T, V>::~dense_matrix() {}
 template <typename T, class V>
 T dense_matrix<T, V>::get(size_t r, size_t c) { 
     check_oneargs(r, c);
-    return x[r + c*(this->nrow)]; 
+    return *(x.begin() + r + c*(this->nrow)); 
 }
 
 template <typename T, class V>
@@ -79,7 +88,43 @@ template <class Iter>
 void dense_matrix<T, V>::get_col(size_t c, Iter out, size_t first, size_t last) {
     check_colargs(c, first, last);
     auto src=x.begin() + c*(this->nrow);
-    std::copy(src+first, src+last, out);
+    copy_values(src+first, last-first, out);
+    return;
+}
+
+template <typename T, class V>
+template <class Iter>
+void dense_matrix<T, V>::get_cols(size_t first_col, size_t last_col, Iter out, size_t first, size_t last) {
+    check_colsargs(first_col, last_col, first, last);
+    const size_t& NR=this->nrow;
+    auto src=x.begin() + first_col*NR;
+    if (first==0 && last==NR) { // Columns are contiguous, so we can copy the entire block at once.
+        copy_values(src, (last_col - first_col)*NR, out);
+    } else {
+        const size_t nvals=last-first;
+        for (size_t c=first_col; c<last_col; ++c, src+=NR, out+=nvals) {
+            copy_values(src+first, nvals, out);
+        }
+    }
+    return;
+}
+
+template <typename T, class V>
+template <class Iter>
+void dense_matrix<T, V>::get_col_subset(size_t c, Rcpp::IntegerVector::const_iterator rows, size_t n, Iter out) {
+    check_colsubset(c, rows, n);
+    auto src=x.begin() + c*(this->nrow);
+    for (size_t i=0; i<n; ++i, ++rows, ++out) { (*out)=*(src + *rows); }
+    return;
+}
+
+template <typename T, class V>
+template <class Iter>
+void dense_matrix<T, V>::get_row_subset(size_t r, Rcpp::IntegerVector::const_iterator cols, size_t n, Iter out) {
+    check_rowsubset(r, cols, n);
+    const size_t& NR=this->nrow;
+    auto src=x.begin() + r;
+    for (size_t i=0; i<n; ++i, ++cols, ++out) { (*out)=*(src + (*cols)*NR); }
     return;
 }
 
@@ -7,7 +7,8 @@
 extern "C" {
 
 static const R_CallMethodDef all_call_entries[] = {
-    REGISTER(rechunk_matrix, 8),
+    REGISTER(rechunk_matrix, 11),
+    REGISTER(transpose_matrix, 9),
     REGISTER(find_chunks, 1),
     {NULL, NULL, 0}
 };
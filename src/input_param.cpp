@@ -0,0 +1,46 @@
+#include "input_param.h"
+
+namespace beachmat {
+
+input_param::input_param() : cache_size(DEFAULT_CACHE_SIZE), prefetch(DEFAULT_PREFETCH), shared_cache(DEFAULT_SHARED_CACHE), threads(DEFAULT_THREADS) {}
+
+void input_param::set_cache_size(size_t c) {
+    cache_size=c;
+    return;
+}
+
+size_t input_param::get_cache_size() const {
+    return cache_size;
+}
+
+void input_param::set_prefetch(bool p) {
+    prefetch=p;
+    return;
+}
+
+bool input_param::get_prefetch() const {
+    return prefetch;
+}
+
+void input_param::set_shared_cache(bool s) {
+    shared_cache=s;
+    return;
+}
+
+bool input_param::get_shared_cache() const {
+    return shared_cache;
+}
+
+void input_param::set_threads(size_t t) {
+    if (t==0) {
+        throw std::runtime_error("number of threads should be positive");
+    }
+    threads=t;
+    return;
+}
+
+size_t input_param::get_threads() const {
+    return threads;
+}
+
+}
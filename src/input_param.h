@@ -0,0 +1,36 @@
+#ifndef BEACHMAT_INPUT_PARAM_H
+#define BEACHMAT_INPUT_PARAM_H
+
+#include "utils.h"
+
+namespace beachmat {
+
+class input_param {
+public:
+    input_param();
+
+    void set_cache_size(size_t);
+    size_t get_cache_size() const;
+
+    void set_prefetch(bool);
+    bool get_prefetch() const;
+
+    void set_shared_cache(bool);
+    bool get_shared_cache() const;
+
+    void set_threads(size_t);
+    size_t get_threads() const;
+
+    static const size_t DEFAULT_CACHE_SIZE=0; // This will trigger use of global cache settings.
+    static const bool DEFAULT_PREFETCH=false;
+    static const bool DEFAULT_SHARED_CACHE=false;
+    static const size_t DEFAULT_THREADS=1;
+private:
+    size_t cache_size;
+    bool prefetch, shared_cache;
+    size_t threads;
+};
+
+}
+
+#endif
@@ -17,17 +17,22 @@ Rcpp::RObject HDF5_output<int, INTSXP>::get_firstval() {
 /* Dispatch definition */
 
 std::unique_ptr<integer_matrix> create_integer_matrix(const Rcpp::RObject& incoming) { 
+    return create_integer_matrix(incoming, input_param());
+}
+
+std::unique_ptr<integer_matrix> create_integer_matrix(const Rcpp::RObject& incoming, const input_param& param) { 
     if (incoming.isS4()) { 
         std::string ctype=get_class(incoming);
         if (ctype=="HDF5Matrix") { 
-            return std::unique_ptr<integer_matrix>(new HDF5_integer_matrix(incoming));
+            return std::unique_ptr<integer_matrix>(new HDF5_integer_matrix(incoming, 
+                        param.get_cache_size(), param.get_prefetch(), param.get_shared_cache(), param.get_threads()));
         } else if (ctype=="RleMatrix") {
             return std::unique_ptr<integer_matrix>(new Rle_integer_matrix(incoming));
         } else if (ctype=="DelayedMatrix") { 
             if (is_pristine_delayed_array(incoming)) { 
-                return create_integer_matrix(get_safe_slot(incoming, "seed"));
+                return create_integer_matrix(get_safe_slot(incoming, "seed"), param);
             } else {
-                return create_integer_matrix(realize_delayed_array(incoming));
+                return create_integer_matrix(realize_delayed_array(incoming), param);
             }
         }
         std::stringstream err;
@@ -45,7 +50,8 @@ std::unique_ptr<integer_output> create_integer_output(int nrow, int ncol, const
             return std::unique_ptr<integer_output>(new simple_integer_output(nrow, ncol));
         case HDF5:
             return std::unique_ptr<integer_output>(new HDF5_integer_output(nrow, ncol,
-                        param.get_chunk_nrow(), param.get_chunk_ncol(), param.get_compression()));
+                        param.get_chunk_nrow(), param.get_chunk_ncol(), param.get_compression(), param.get_cache_size(), param.get_threads(),
+                        param.get_storage_type()));
         default:
             throw std::runtime_error("unsupported output mode for integer matrices");
     }
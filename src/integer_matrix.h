@@ -28,6 +28,8 @@ typedef HDF5_lin_matrix<int, Rcpp::IntegerVector, INTSXP> HDF5_integer_matrix;
 
 std::unique_ptr<integer_matrix> create_integer_matrix(const Rcpp::RObject&);
 
+std::unique_ptr<integer_matrix> create_integer_matrix(const Rcpp::RObject&, const input_param&);
+
 /***************************************************
  * Virtual base class for output integer matrices. *
  ***************************************************/
@@ -40,6 +40,8 @@ typedef HDF5_lin_matrix<int, Rcpp::LogicalVector, LGLSXP> HDF5_logical_matrix;
 
 std::unique_ptr<logical_matrix> create_logical_matrix(const Rcpp::RObject&);
 
+std::unique_ptr<logical_matrix> create_logical_matrix(const Rcpp::RObject&, const input_param&);
+
 /***************************************************
  * Virtual base class for output logical matrices. *
  ***************************************************/
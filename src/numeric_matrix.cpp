@@ -27,6 +27,10 @@ Rcpp::RObject HDF5_output<double, REALSXP>::get_firstval() {
 /* Dispatch definition */
 
 std::unique_ptr<numeric_matrix> create_numeric_matrix(const Rcpp::RObject& incoming) { 
+    return create_numeric_matrix(incoming, input_param());
+}
+
+std::unique_ptr<numeric_matrix> create_numeric_matrix(const Rcpp::RObject& incoming, const input_param& param) { 
     if (incoming.isS4()) {
         std::string ctype=get_class(incoming);
         if (ctype=="dgeMatrix") { 
@@ -38,14 +42,15 @@ std::unique_ptr<numeric_matrix> create_numeric_matrix(const Rcpp::RObject& incom
         } else if (ctype=="dspMatrix") {
             return std::unique_ptr<numeric_matrix>(new Psymm_numeric_matrix(incoming));
         } else if (ctype=="HDF5Matrix") {
-            return std::unique_ptr<numeric_matrix>(new HDF5_numeric_matrix(incoming));
+            return std::unique_ptr<numeric_matrix>(new HDF5_numeric_matrix(incoming, 
+                        param.get_cache_size(), param.get_prefetch(), param.get_shared_cache(), param.get_threads()));
         } else if (ctype=="RleMatrix") {
             return std::unique_ptr<numeric_matrix>(new Rle_numeric_matrix(incoming));
         } else if (ctype=="DelayedMatrix") { 
             if (is_pristine_delayed_array(incoming)) { 
-                return create_numeric_matrix(get_safe_slot(incoming, "seed"));
+                return create_numeric_matrix(get_safe_slot(incoming, "seed"), param);
             } else {
-                return create_numeric_matrix(realize_delayed_array(incoming));
+                return create_numeric_matrix(realize_delayed_array(incoming), param);
             }
         }
         throw_custom_error("unsupported class '", ctype, "' for numeric_matrix");
@@ -60,10 +65,11 @@ std::unique_ptr<numeric_output> create_numeric_output(int nrow, int ncol, const
         case SIMPLE:
             return std::unique_ptr<numeric_output>(new simple_numeric_output(nrow, ncol));
         case SPARSE:
-            return std::unique_ptr<numeric_output>(new sparse_numeric_output(nrow, ncol));
+            return std::unique_ptr<numeric_output>(new sparse_numeric_output(nrow, ncol, param.get_memory_limit(), param.get_threads()));
         case HDF5:
             return std::unique_ptr<numeric_output>(new HDF5_numeric_output(nrow, ncol, 
-                        param.get_chunk_nrow(), param.get_chunk_ncol(), param.get_compression()));
+                        param.get_chunk_nrow(), param.get_chunk_ncol(), param.get_compression(), param.get_cache_size(), param.get_threads(),
+                        param.get_storage_type()));
         default:
             throw std::runtime_error("unsupported output mode for numeric matrices");
     }
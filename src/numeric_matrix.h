@@ -38,6 +38,8 @@ typedef HDF5_lin_matrix<double, Rcpp::NumericVector, REALSXP> HDF5_numeric_matri
 
 std::unique_ptr<numeric_matrix> create_numeric_matrix(const Rcpp::RObject&);
 
+std::unique_ptr<numeric_matrix> create_numeric_matrix(const Rcpp::RObject&, const input_param&);
+
 /***************************************************
  * Virtual base class for output numeric matrices. *
  ***************************************************/
@@ -3,7 +3,8 @@
 namespace beachmat {
 
 output_param::output_param (matrix_type m) : mode(m), chunk_nr(DEFAULT_CHUNKDIM), chunk_nc(DEFAULT_CHUNKDIM), 
-    compress(DEFAULT_COMPRESS), strlen(DEFAULT_STRLEN) {}
+    compress(DEFAULT_COMPRESS), strlen(DEFAULT_STRLEN), cache_size(DEFAULT_CACHE_SIZE), threads(DEFAULT_THREADS), 
+    memory_limit(DEFAULT_MEMORY_LIMIT), storage(DEFAULT_STORAGE_TYPE) {}
 
 output_param::output_param (const Rcpp::RObject& in, bool simplify, bool preserve_zero) : output_param(SIMPLE) { 
     if (!in.isS4()) {
@@ -103,6 +104,75 @@ size_t output_param::get_strlen() const {
     return strlen;
 }
 
+void output_param::set_cache_size(size_t c) {
+    cache_size=c;
+    return;
+}
+
+size_t output_param::get_cache_size() const {
+    return cache_size;
+}
+
+void output_param::set_threads(size_t t) {
+    if (t==0) {
+        throw std::runtime_error("number of threads should be positive");
+    }
+    threads=t;
+    return;
+}
+
+size_t output_param::get_threads() const {
+    return threads;
+}
+
+void output_param::set_memory_limit(size_t m) {
+    memory_limit=m;
+    return;
+}
+
+size_t output_param::get_memory_limit() const {
+    return memory_limit;
+}
+
+void output_param::set_single_precision(bool s) {
+    storage=(s ? FLOAT_STORAGE : DEFAULT_STORAGE);
+    return;
+}
+
+bool output_param::get_single_precision() const {
+    return storage==FLOAT_STORAGE;
+}
+
+void output_param::set_storage_type(storage_type s) {
+    storage=s;
+    return;
+}
+
+storage_type output_param::get_storage_type() const {
+    return storage;
+}
+
+/* Choosing the narrowest integer type that can store all values in the declared range.
+ * Unsigned types are tried first as they can store twice as many non-negative values.
+ */
+
+void output_param::set_integer_range(int lower, int upper) {
+    if (lower > upper) {
+        throw std::runtime_error("lower bound of the integer range should not be greater than the upper bound");
+    }
+    const storage_type candidates[]={ UINT8_STORAGE, INT8_STORAGE, UINT16_STORAGE, INT16_STORAGE };
+    for (auto s : candidates) {
+        int smallest, largest;
+        get_storage_limits(s, smallest, largest);
+        if (lower >= smallest && upper <= largest) {
+            storage=s;
+            return;
+        }
+    }
+    storage=DEFAULT_STORAGE;
+    return;
+}
+
 const output_param SIMPLE_PARAM(SIMPLE);
 const output_param SPARSE_PARAM(SPARSE);
 const output_param HDF5_PARAM(HDF5);
@@ -24,14 +24,38 @@ public:
     void set_strlen(size_t);
     size_t get_strlen() const;
 
+    void set_cache_size(size_t);
+    size_t get_cache_size() const;
+
+    void set_threads(size_t);
+    size_t get_threads() const;
+
+    void set_memory_limit(size_t);
+    size_t get_memory_limit() const;
+
+    void set_single_precision(bool);
+    bool get_single_precision() const;
+
+    void set_storage_type(storage_type);
+    storage_type get_storage_type() const;
+    void set_integer_range(int, int);
+
     static const size_t DEFAULT_CHUNKDIM=0; // This will trigger use of global chunk settings.
     static const int DEFAULT_COMPRESS=-1; // This will trigger use of global compression settings.
     static const size_t DEFAULT_STRLEN=10;
+    static const size_t DEFAULT_CACHE_SIZE=0; // This will trigger use of global cache settings.
+    static const size_t DEFAULT_THREADS=1;
+    static const size_t DEFAULT_MEMORY_LIMIT=0; // No limit.
+    static const storage_type DEFAULT_STORAGE_TYPE=DEFAULT_STORAGE; // Storing values in their memory type.
 private:
     matrix_type mode;
     size_t chunk_nr, chunk_nc;
     int compress;
     size_t strlen;
+    size_t cache_size;
+    size_t threads;
+    size_t memory_limit;
+    storage_type storage;
 };
 
 extern const output_param SIMPLE_PARAM;
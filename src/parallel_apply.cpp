@@ -0,0 +1,54 @@
+#include "parallel_apply.h"
+#include "utils.h"
+#include "HDF5_utils.h"
+
+namespace beachmat {
+
+std::vector<size_t> define_parallel_tasks(const Rcpp::RObject& incoming, matrix_type mtype, bool bycol, size_t n, size_t nthreads) {
+    const size_t ntasks=nthreads*4; // A few tasks per thread, to balance the load.
+    std::vector<size_t> bounds(1, 0);
+
+    if (mtype==SPARSE && bycol) {
+        // Balancing the number of non-zero elements (plus one per column, to account for empty columns).
+        Rcpp::IntegerVector p(get_safe_slot(incoming, "p"));
+        if (size_t(p.size())==n+1) {
+            const size_t target=(p[n] + n)/ntasks + 1;
+            size_t last=0;
+            for (size_t c=1; c<=n; ++c) {
+                if (size_t(p[c] - p[last]) + (c - last) >= target || c==n) {
+                    bounds.push_back(c);
+                    last=c;
+                }
+            }
+            return bounds;
+        }
+    }
+
+    // Otherwise, tasks contain equal numbers of whole chunks (for HDF5 matrices) or rows/columns.
+    size_t unit=1;
+    if (mtype==HDF5) {
+        const Rcpp::RObject& h5_seed=get_safe_slot(incoming, "seed");
+        const std::string filename=make_to_string(get_safe_slot(h5_seed, "file"));
+        const std::string dataname=make_to_string(get_safe_slot(h5_seed, "name"));
+
+        std::lock_guard<std::mutex> lock(get_HDF5_mutex());
+        H5::H5File hfile(filename.c_str(), H5F_ACC_RDONLY);
+        H5::DataSet hdata=hfile.openDataSet(dataname.c_str());
+        H5::DSetCreatPropList cparms=hdata.getCreatePlist();
+        if (cparms.getLayout()==H5D_CHUNKED) {
+            hsize_t chunk_dims[2];
+            cparms.getChunk(2, chunk_dims);
+            unit=(bycol ? chunk_dims[0] : chunk_dims[1]); // Data are transposed in the file.
+        }
+    }
+
+    const size_t nunits=(n + unit - 1)/unit;
+    const size_t per_task=std::max(size_t(1), nunits/ntasks)*unit;
+    for (size_t pos=per_task; pos<n; pos+=per_task) {
+        bounds.push_back(pos);
+    }
+    bounds.push_back(n);
+    return bounds;
+}
+
+}
@@ -0,0 +1,116 @@
+#ifndef BEACHMAT_PARALLEL_APPLY_H
+#define BEACHMAT_PARALLEL_APPLY_H
+
+#include "beachmat.h"
+#include "LIN_matrix.h"
+#include "character_matrix.h"
+
+namespace beachmat {
+
+/* Splits the rows or columns of a matrix into contiguous tasks, returning the task boundaries.
+ * Tasks consist of whole chunks for HDF5 matrices, and contain similar numbers of non-zero
+ * elements for the columns of sparse matrices. This uses the R API, so it must be called
+ * from the main thread.
+ */
+
+std::vector<size_t> define_parallel_tasks(const Rcpp::RObject&, matrix_type, bool, size_t, size_t);
+
+/* Applies a function to each row or column of a matrix on multiple threads. Each thread 
+ * operates on its own clone and repeatedly takes the next task from a shared counter, so 
+ * threads that finish early pick up the remaining work. The function is called as 
+ * 'fun(matrix, index, thread)' and should only use the supplied matrix, e.g., calling 
+ * 'get_col(index, ...)' and storing results in the part of a pre-allocated output that 
+ * corresponds to 'index'. The 'thread' argument can be used to select per-thread workspaces.
+ * Clones are created and destroyed on the calling thread, which also processes tasks;
+ * the function itself must not use the R API, e.g., by allocating Rcpp vectors.
+ */
+
+template<class M, class FUN>
+void run_parallel_tasks(M& mat, FUN& fun, size_t nthreads, bool bycol) {
+    const size_t n=(bycol ? mat.get_ncol() : mat.get_nrow());
+    if (nthreads <= 1 || n <= 1) {
+        for (size_t i=0; i<n; ++i) {
+            fun(mat, i, 0);
+        }
+        return;
+    }
+
+    const std::vector<size_t> bounds=define_parallel_tasks(mat.yield(), mat.get_matrix_type(), bycol, n, nthreads);
+    const size_t ntasks=bounds.size() - 1;
+    nthreads=std::min(nthreads, ntasks);
+    std::vector<std::unique_ptr<M> > clones;
+    for (size_t t=1; t<nthreads; ++t) {
+        clones.push_back(mat.clone());
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr failure;
+    std::mutex failure_lock;
+
+    auto work=[&](M& current, size_t thread) -> void {
+        while (true) {
+            const size_t i=next++;
+            if (i>=ntasks) {
+                break;
+            }
+            try {
+                for (size_t j=bounds[i]; j<bounds[i+1]; ++j) {
+                    fun(current, j, thread);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lk(failure_lock);
+                if (!failure) {
+                    failure=std::current_exception();
+                }
+                next=ntasks; // Stopping the other workers as soon as possible.
+            }
+        }
+        return;
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t t=1; t<nthreads; ++t) {
+        pool.push_back(std::thread(work, std::ref(*clones[t-1]), t));
+    }
+    work(mat, 0);
+    for (auto& p : pool) {
+        p.join();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return;
+}
+
+template<typename T, class V, class FUN>
+void parallel_apply_cols(lin_matrix<T, V>& mat, FUN fun, size_t nthreads) {
+    run_parallel_tasks(mat, fun, nthreads, true);
+    return;
+}
+
+template<typename T, class V, class FUN>
+void parallel_apply_rows(lin_matrix<T, V>& mat, FUN fun, size_t nthreads) {
+    run_parallel_tasks(mat, fun, nthreads, false);
+    return;
+}
+
+/* Character matrices are always processed on the calling thread, as extracting strings 
+ * requires the R API. The number of threads is only accepted for a consistent interface.
+ */
+
+template<class FUN>
+void parallel_apply_cols(character_matrix& mat, FUN fun, size_t) {
+    run_parallel_tasks(mat, fun, 1, true);
+    return;
+}
+
+template<class FUN>
+void parallel_apply_rows(character_matrix& mat, FUN fun, size_t) {
+    run_parallel_tasks(mat, fun, 1, false);
+    return;
+}
+
+}
+
+#endif
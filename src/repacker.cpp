@@ -1,19 +1,25 @@
 #include "beachmat.h"
 #include "functions.h"
+#include "HDF5_chunks.h"
 
 /********************* A rechunking class ************************/
 
+/* This also handles transposition, where the output data set contains the transpose of
+ * the input matrix. Blocks are then transposed in memory before being written, and must
+ * be aligned to the transposed output chunks; everything else is the same as rechunking.
+ */
+
 template<typename T, bool use_size>
 class rechunker {
 public: 
     rechunker(const std::string& input_file, const std::string& input_data, 
               const std::string& output_file, const std::string& output_data,
-              int compress, size_t cs, bool br) : 
+              int compress, size_t cs, bool br, size_t nt, size_t onr, size_t onc, size_t memory, bool tr=false) : 
         ihfile(H5std_string(input_file), H5F_ACC_RDONLY),
         ihdata(ihfile.openDataSet(H5std_string(input_data))),
         HDT(ihdata.getDataType()),
         ohfile(H5std_string(output_file), H5F_ACC_RDWR),
-        chunksize(cs), byrow(br)
+        chunksize(cs), byrow(br), nthreads(nt), transposed(tr)
     {
         // Setting up the input structures.
         H5::DataSpace ihspace=ihdata.getSpace(); 
@@ -21,6 +27,13 @@ public:
             throw std::runtime_error("rechunking is not supported for arrays");
         }
         ihspace.getSimpleExtentDims(dims);
+        if (transposed) {
+            out_dims[0]=nrows();
+            out_dims[1]=ncols();
+        } else {
+            out_dims[0]=ncols();
+            out_dims[1]=nrows();
+        }
        
         H5::DSetCreatPropList cparms = ihdata.getCreatePlist();
         if (cparms.getLayout()==H5D_CONTIGUOUS) {
@@ -31,9 +44,14 @@ public:
             cparms.getChunk(2, chunk_dims);
         }
         
-        // Specifying the output chunk size.
+        // Specifying the output chunk size; arbitrary dimensions override the pure row/column layouts.
         H5::DSetCreatPropList oparms; 
-        if (byrow) { 
+        if (onr && onc) {
+            out_chunk_nrows()=std::min(hsize_t(onr), out_nrows());
+            out_chunk_ncols()=std::min(hsize_t(onc), out_ncols());
+        } else if (transposed) {
+            throw std::runtime_error("chunk dimensions must be specified for transposition");
+        } else if (byrow) { 
             if (chunksize > ncols()) { chunksize=ncols(); }
             out_chunk_ncols()=chunksize;
             out_chunk_nrows()=1;
@@ -46,34 +64,107 @@ public:
         oparms.setChunk(2, out_chunk_dims);
         oparms.setDeflate(compress);
 
-        /* Holding one chunk in memory (the incompletely read and written one between iterations).
-         * No need for fancy nslots calculations, and we evict fully read chunks first (not that
-         * it really matters, because there's only one chunk being held in memory).
+        // Extents of the output chunks along the rows and columns of the input matrix.
+        const hsize_t align_nr=(transposed ? out_chunk_ncols() : out_chunk_nrows());
+        const hsize_t align_nc=(transposed ? out_chunk_nrows() : out_chunk_ncols());
+        if (onr && onc) {
+            byrow=(align_nr <= align_nc);
+        }
+
+        /* Choosing the block dimensions. Each block consists of complete input and output chunks,
+         * so every input chunk is decompressed exactly once and every output chunk is written once.
+         * Blocks are then extended along the inner dimension (and along the outer dimension, once
+         * the inner dimension is spanned) to fill the memory budget. If a single aligned block
+         * exceeds the budget, both dimensions are only aligned to the output chunks; any input
+         * chunks straddling consecutive blocks are then held in the HDF5 chunk cache instead.
+         */
+        const size_t elsize=(use_size ? HDT.getSize() : sizeof(T));
+        const hsize_t budget=std::max(hsize_t(1), hsize_t(memory/elsize));
+        hsize_t unit_nr=choose_unit(chunk_nrows(), align_nr, nrows());
+        hsize_t unit_nc=choose_unit(chunk_ncols(), align_nc, ncols());
+
+        if (byrow) {
+            if (unit_nr*unit_nc > budget) { 
+                unit_nr=std::max(hsize_t(1), align_nr); 
+                unit_nc=std::max(hsize_t(1), align_nc); 
+            }
+            block_nrows()=unit_nr;
+            block_ncols()=extend_unit(unit_nc, ncols(), budget/block_nrows());
+            if (block_ncols() >= ncols() && ncols()) {
+                block_nrows()=extend_unit(unit_nr, nrows(), budget/ncols());
+            }
+        } else {
+            if (unit_nr*unit_nc > budget) { 
+                unit_nr=std::max(hsize_t(1), align_nr); 
+                unit_nc=std::max(hsize_t(1), align_nc); 
+            }
+            block_ncols()=unit_nc;
+            block_nrows()=extend_unit(unit_nr, nrows(), budget/block_ncols());
+            if (block_nrows() >= nrows() && nrows()) {
+                block_ncols()=extend_unit(unit_nc, ncols(), budget/nrows());
+            }
+        }
+
+        /* Counting the input chunks straddling consecutive blocks. Along the inner dimension, these
+         * are the chunks at the end of each block (plus one, if the block is not aligned to the 
+         * input chunks along the outer dimension). Along the outer dimension, these are all chunks
+         * at the end of each sweep across the inner dimension.
+         */
+        size_t nstraddling=0;
+        if (byrow) {
+            const bool outer=(block_nrows() < nrows() && block_nrows() % chunk_nrows());
+            if (block_ncols() < ncols() && block_ncols() % chunk_ncols()) {
+                nstraddling+=(block_nrows() + chunk_nrows() - 1)/chunk_nrows() + outer;
+            }
+            if (outer) {
+                nstraddling+=(ncols() + chunk_ncols() - 1)/chunk_ncols();
+            }
+        } else {
+            const bool outer=(block_ncols() < ncols() && block_ncols() % chunk_ncols());
+            if (block_nrows() < nrows() && block_nrows() % chunk_nrows()) {
+                nstraddling+=(block_ncols() + chunk_ncols() - 1)/chunk_ncols() + outer;
+            }
+            if (outer) {
+                nstraddling+=(nrows() + chunk_nrows() - 1)/chunk_nrows();
+            }
+        }
+
+        /* Holding the straddling chunks in memory, or one chunk if there are none. No need for 
+         * fancy nslots calculations in the latter case, and we evict fully read chunks first.
+         * The cache is also limited by the memory budget, beyond which straddling chunks are
+         * simply decompressed again when the next block is read.
          */
         H5::FileAccPropList inputlist(ihfile.getAccessPlist().getId());
         const size_t cache_size=chunk_ncols()*chunk_nrows()*HDT.getSize();
-        inputlist.setCache(0, 1, cache_size, 1); 
+        if (nstraddling) {
+            inputlist.setCache(0, next_prime(100*nstraddling), std::min(cache_size*nstraddling, std::max(cache_size, memory)), 1); 
+        } else {
+            inputlist.setCache(0, 1, cache_size, 1); 
+        }
 
         ihdata.close();
         ihfile.close();
         ihfile.openFile(H5std_string(input_file), H5F_ACC_RDONLY, inputlist);
         ihdata=ihfile.openDataSet(H5std_string(input_data));
 
+        /* Reading input chunks directly and decompressing them in parallel, if requested and possible.
+         * Chunks are not stored in the shared cache as each input chunk is only read once;
+         * straddling chunks are left to the HDF5 chunk cache, so the engine is not used.
+         */
+        if (nthreads > 1 && !nstraddling) {
+            engine.initialize(input_file, input_data, ihdata, HDT, nrows(), ncols(), 0, false);
+        }
+
         // Creating the output data set.
-        H5::DataSpace ohspace(2, dims);
+        H5::DataSpace ohspace(2, out_dims);
         ohdata=ohfile.createDataSet(output_data, HDT, ohspace, oparms); 
 
         // Setting up the data space and the storage space.
         mat_space.setExtentSimple(2, dims);
 
         hsize_t store_dims[2];
-        if (byrow) {
-            store_dims[0]=chunksize; // store_dims, NOT store_counts!
-            store_dims[1]=chunk_nrows();
-        } else {
-            store_dims[0]=chunk_ncols();
-            store_dims[1]=chunksize;
-        }
+        store_dims[0]=block_ncols(); // store_dims, NOT store_counts!
+        store_dims[1]=block_nrows();
         store_space.setExtentSimple(2, store_dims);
         store_rowpos()=0;
         store_colpos()=0;
@@ -81,11 +172,21 @@ public:
         size_t store_size=store_dims[0]*store_dims[1]; // store_dims, NOT store_counts!
         if (use_size) { store_size *= HDT.getSize(); }
         storage.resize(store_size);
+        if (transposed) {
+            flipped.resize(store_size);
+        }
+
+        // Also compressing output chunks in parallel, allowing a few blocks to be queued at once.
+        if (nthreads > 1) {
+            writer.initialize(ohdata, HDT, out_nrows(), out_ncols(), nthreads, 4*storage.size()*sizeof(T), true);
+        }
         return;
     }
 
     void execute() {
-        if (byrow) {
+        if (nthreads > 1) {
+            execute_pipeline();
+        } else if (byrow) {
             fill_by_row();
         } else {
             fill_by_col();
@@ -111,8 +212,10 @@ private:
 
     H5::H5File ohfile;
     H5::DataSet ohdata;
+    hsize_t out_dims[2];
     hsize_t out_chunk_dims[2];
     size_t chunksize;
+    hsize_t block_dims[2];
     
     H5::DataSpace store_space;
     hsize_t store_offset[2];
@@ -121,6 +224,24 @@ private:
 
     bool byrow;
 
+    size_t nthreads;
+    bool transposed;
+    std::vector<T> flipped;
+    beachmat::HDF5_chunk_engine engine;
+    beachmat::HDF5_chunk_writer writer;
+
+    // Pipeline state, for passing blocks from the reader thread to the writing thread.
+    struct pending_block {
+        size_t buffer;
+        hsize_t offset[2], count[2];
+    };
+    std::vector<std::vector<T> > buffers;
+    std::deque<size_t> free_buffers;
+    std::deque<pending_block> filled_buffers;
+    std::mutex pipe_lock;
+    std::condition_variable pipe_cv;
+    bool reading_done, aborted;
+
     // Convenience getters.
     const hsize_t& chunk_ncols () { return chunk_dims[0]; }
     const hsize_t& chunk_nrows () { return chunk_dims[1]; }
@@ -128,9 +249,57 @@ private:
     const hsize_t& ncols () const { return dims[0]; }
     const hsize_t& nrows () const { return dims[1]; }
 
+    const hsize_t& out_ncols () const { return out_dims[0]; }
+    const hsize_t& out_nrows () const { return out_dims[1]; }
+
     hsize_t& out_chunk_ncols () { return out_chunk_dims[0]; }
     hsize_t& out_chunk_nrows () { return out_chunk_dims[1]; }
 
+    hsize_t& block_ncols () { return block_dims[0]; }
+    hsize_t& block_nrows () { return block_dims[1]; }
+
+    // Least common multiple of the input and output chunk extents, capped at the matrix extent.
+    static hsize_t choose_unit(hsize_t in, hsize_t out, hsize_t full) {
+        if (!in || !out) {
+            return std::max(hsize_t(1), std::min(std::max(in, out), full));
+        }
+        hsize_t a=in, b=out;
+        while (b) {
+            const hsize_t tmp=a%b;
+            a=b;
+            b=tmp;
+        }
+        const hsize_t step=in/a;
+        if (step > full/out) {
+            return std::max(hsize_t(1), full);
+        }
+        return std::max(hsize_t(1), std::min(full, step*out));
+    }
+
+    // Largest multiple of the unit that fits in the allowance (but at least one unit), capped at the matrix extent.
+    static hsize_t extend_unit(hsize_t unit, hsize_t full, hsize_t allowance) {
+        const hsize_t nunits=std::max(hsize_t(1), allowance/unit);
+        if (nunits > full/unit) {
+            return std::max(unit, full);
+        }
+        return nunits*unit;
+    }
+
+    static size_t next_prime(size_t x) {
+        for (size_t candidate=std::max(x, size_t(2)); ; ++candidate) {
+            bool prime=true;
+            for (size_t d=2; d*d<=candidate; ++d) {
+                if (candidate % d==0) {
+                    prime=false;
+                    break;
+                }
+            }
+            if (prime) {
+                return candidate;
+            }
+        }
+    }
+
     hsize_t& query_colpos () { return mat_offset[0]; }
     hsize_t& query_rowpos () { return mat_offset[1]; }
     hsize_t& query_ncols () { return mat_count[0]; }
@@ -141,11 +310,221 @@ private:
     hsize_t& store_ncols () { return store_count[0]; }
     hsize_t& store_nrows () { return store_count[1]; }
 
+    /* Actually reading and writing the current block. In the pipelined case, the block
+     * is read into a free buffer and passed to the writing thread instead.
+     */
+    void transfer() {
+        if (nthreads > 1) {
+            enqueue();
+            return;
+        }
+        if (transposed) {
+            read_block(reinterpret_cast<char*>(storage.data()), mat_offset, mat_count);
+            write_block(storage.data(), mat_offset, mat_count);
+            return;
+        }
+        mat_space.selectHyperslab(H5S_SELECT_SET, mat_count, mat_offset);
+        store_space.selectHyperslab(H5S_SELECT_SET, store_count, store_offset);
+        ihdata.read(storage.data(), HDT, store_space, mat_space);
+        ohdata.write(storage.data(), HDT, store_space, mat_space);
+        return;
+    }
+
+    /* Three-stage pipeline with bounded queues. The reader thread runs the usual fill_by_* loop,
+     * reading (and decompressing, via the engine) each block into one of several buffers. The
+     * calling thread takes filled blocks in order and assembles them into output chunks, which 
+     * are compressed by the writer's worker threads and committed in order. Each block is stored 
+     * contiguously in its buffer and consists of complete output chunks. All HDF5 calls are 
+     * made while holding the HDF5 lock, as reading and writing now occur in different threads.
+     */
+    void execute_pipeline() {
+        const size_t nbuffers=3;
+        buffers.assign(nbuffers-1, storage);
+        buffers.push_back(std::move(storage)); // 'storage' is not otherwise used in the pipeline.
+        free_buffers.clear();
+        for (size_t b=0; b<nbuffers; ++b) {
+            free_buffers.push_back(b);
+        }
+        filled_buffers.clear();
+        reading_done=false;
+        aborted=false;
+
+        std::exception_ptr read_error;
+        std::thread reader([&]() -> void {
+            try {
+                if (byrow) {
+                    fill_by_row();
+                } else {
+                    fill_by_col();
+                }
+            } catch (...) {
+                read_error=std::current_exception();
+            }
+            std::lock_guard<std::mutex> lk(pipe_lock);
+            reading_done=true;
+            pipe_cv.notify_all();
+        });
+
+        try {
+            while (true) {
+                pending_block current;
+                {
+                    std::unique_lock<std::mutex> lk(pipe_lock);
+                    pipe_cv.wait(lk, [&]() -> bool { return !filled_buffers.empty() || reading_done; });
+                    if (filled_buffers.empty()) {
+                        break;
+                    }
+                    current=filled_buffers.front();
+                    filled_buffers.pop_front();
+                }
+
+                write_block(buffers[current.buffer].data(), current.offset, current.count);
+                {
+                    std::lock_guard<std::mutex> lk(pipe_lock);
+                    free_buffers.push_back(current.buffer);
+                    pipe_cv.notify_all();
+                }
+            }
+
+            if (!read_error && writer.is_active()) {
+                writer.finish(ohdata);
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lk(pipe_lock);
+                aborted=true;
+                pipe_cv.notify_all();
+            }
+            reader.join();
+            throw;
+        }
+
+        reader.join();
+        if (read_error) {
+            std::rethrow_exception(read_error);
+        }
+        return;
+    }
+
+    void enqueue() {
+        pending_block current;
+        {
+            std::unique_lock<std::mutex> lk(pipe_lock);
+            pipe_cv.wait(lk, [&]() -> bool { return !free_buffers.empty() || aborted; });
+            if (aborted) {
+                return;
+            }
+            current.buffer=free_buffers.front();
+            free_buffers.pop_front();
+        }
+        std::copy(mat_offset, mat_offset+2, current.offset);
+        std::copy(mat_count, mat_count+2, current.count);
+
+        read_block(reinterpret_cast<char*>(buffers[current.buffer].data()), current.offset, current.count);
+
+        std::lock_guard<std::mutex> lk(pipe_lock);
+        filled_buffers.push_back(current);
+        pipe_cv.notify_all();
+        return;
+    }
+
+    // Reading a block contiguously into 'dest'; 'offset' and 'count' are in file coordinates (i.e., column first).
+    void read_block(char* dest, const hsize_t* offset, const hsize_t* count) {
+        if (engine.is_active()) {
+            engine.extract_block(offset[1], offset[1] + count[1], offset[0], offset[0] + count[0], dest, ihdata, nthreads);
+        } else {
+            std::lock_guard<std::mutex> hlock(beachmat::get_HDF5_mutex());
+            H5::DataSpace filespace=ihdata.getSpace();
+            filespace.selectHyperslab(H5S_SELECT_SET, count, offset);
+            H5::DataSpace memspace(2, count);
+            ihdata.read(dest, HDT, memspace, filespace);
+        }
+        return;
+    }
+
+    // Writing a contiguous block to the output, transposing it first if necessary.
+    void write_block(const T* values, const hsize_t* offset, const hsize_t* count) {
+        hsize_t out_offset[2], out_count[2];
+        if (transposed) {
+            transpose_block(values, flipped.data(), count[1], count[0], HDT.getSize());
+            values=flipped.data();
+            out_offset[0]=offset[1];
+            out_offset[1]=offset[0];
+            out_count[0]=count[1];
+            out_count[1]=count[0];
+        } else {
+            std::copy(offset, offset+2, out_offset);
+            std::copy(count, count+2, out_count);
+        }
+
+        // The writer only takes the HDF5 lock for each chunk commit, so that the reader is not blocked during assembly or back-pressure.
+        const char* src=reinterpret_cast<const char*>(values);
+        if (writer.is_active()) {
+            writer.write_block(out_offset[1], out_offset[1] + out_count[1], out_offset[0], out_offset[0] + out_count[0], src, ohdata);
+        } else {
+            std::lock_guard<std::mutex> hlock(beachmat::get_HDF5_mutex());
+            H5::DataSpace filespace=ohdata.getSpace();
+            filespace.selectHyperslab(H5S_SELECT_SET, out_count, out_offset);
+            H5::DataSpace memspace(2, out_count);
+            ohdata.write(src, HDT, memspace, filespace);
+        }
+        return;
+    }
+
+    /* Cache-blocked transposition of a column-major NR*NC matrix into a column-major NC*NR matrix.
+     * Values are moved as raw elements of the file type, which need not be the same as T.
+     * Tiles are small enough that the source and destination of each tile stay in the L1 cache.
+     */
+    template<typename E>
+    static void transpose_elements(const E* in, E* out, size_t NR, size_t NC) {
+        const size_t tile=16;
+        for (size_t c0=0; c0<NC; c0+=tile) {
+            const size_t c1=std::min(NC, c0+tile);
+            for (size_t r0=0; r0<NR; r0+=tile) {
+                const size_t r1=std::min(NR, r0+tile);
+                for (size_t c=c0; c<c1; ++c) {
+                    const E* src=in + c*NR;
+                    for (size_t r=r0; r<r1; ++r) {
+                        out[r*NC + c]=src[r];
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    static void transpose_block(const T* values, T* dest, size_t NR, size_t NC, size_t elsize) {
+        const char* in=reinterpret_cast<const char*>(values);
+        char* out=reinterpret_cast<char*>(dest);
+        switch (elsize) {
+            case 1:
+                transpose_elements(reinterpret_cast<const uint8_t*>(in), reinterpret_cast<uint8_t*>(out), NR, NC);
+                break;
+            case 2:
+                transpose_elements(reinterpret_cast<const uint16_t*>(in), reinterpret_cast<uint16_t*>(out), NR, NC);
+                break;
+            case 4:
+                transpose_elements(reinterpret_cast<const uint32_t*>(in), reinterpret_cast<uint32_t*>(out), NR, NC);
+                break;
+            case 8:
+                transpose_elements(reinterpret_cast<const uint64_t*>(in), reinterpret_cast<uint64_t*>(out), NR, NC);
+                break;
+            default:
+                for (size_t c=0; c<NC; ++c) {
+                    for (size_t r=0; r<NR; ++r) {
+                        const char* src=in + (c*NR + r)*elsize;
+                        std::copy(src, src+elsize, out + (r*NC + c)*elsize);
+                    }
+                }
+        }
+        return;
+    }
+
     /* Filling for row-based chunks. The idea is to read/write blocks of X*Y, where
-     * X is the number of rows in the input chunks and Y is the size of the output
-     * chunk. This is repeated across the columns of the input matrix, and then
-     * the function jumps to the next "X" rows. This approach ensures that half-read
-     * input chunks in the cache are also written.
+     * X is the number of rows in each block and Y is the number of columns. This is 
+     * repeated across the columns of the input matrix, and then the function jumps 
+     * to the next "X" rows. This approach ensures that half-read input chunks in the 
+     * cache are also written.
      */
     void fill_by_row() {
         size_t currentrow=0, currentcol=0;
@@ -154,30 +533,26 @@ private:
         while (currentrow < nrows()) { 
             currentcol=0;
             query_rowpos()=currentrow;
-            const size_t nextrow=currentrow+chunk_nrows();
+            const size_t nextrow=currentrow+block_nrows();
             if (nextrow > nrows()) { 
                 query_nrows()=nrows() - currentrow;
             } else {
-                query_nrows()=chunk_nrows();
+                query_nrows()=block_nrows();
             }
             store_nrows()=query_nrows();
 
             // Middle loop across columns. 
             while (currentcol < ncols()) {
                 query_colpos()=currentcol; 
-                const size_t nextcol=currentcol+chunksize;
+                const size_t nextcol=currentcol+block_ncols();
                 if (nextcol > ncols()) { 
                     query_ncols()=ncols() - currentcol;
                 } else {
-                    query_ncols()=chunksize;
+                    query_ncols()=block_ncols();
                 }
                 store_ncols()=query_ncols();
 
-                // Actually reading and writing.
-                store_space.selectHyperslab(H5S_SELECT_SET, store_count, store_offset);
-                mat_space.selectHyperslab(H5S_SELECT_SET, mat_count, mat_offset);
-                ihdata.read(storage.data(), HDT, store_space, mat_space);
-                ohdata.write(storage.data(), HDT, store_space, mat_space);
+                transfer();
                 
                 currentcol=nextcol;
             }
@@ -187,9 +562,9 @@ private:
     }
 
     /* Filling for column-based chunks. The idea is to read/write blocks of X*Y, where
-     * X is the size of the output chunk and Y is the number of columns in the input 
-     * chunk. This is repeated across the rows of the input matrix, and then
-     * the function jumps to the next "Y" columns. 
+     * X is the number of rows in each block and Y is the number of columns. This is 
+     * repeated across the rows of the input matrix, and then the function jumps to 
+     * the next "Y" columns. 
      */
     void fill_by_col() {
         size_t currentcol=0, currentrow=0;
@@ -198,30 +573,26 @@ private:
         while (currentcol < ncols()) { 
             currentrow=0;
             query_colpos()=currentcol;
-            const size_t nextcol=currentcol+chunk_ncols();
+            const size_t nextcol=currentcol+block_ncols();
             if (nextcol > ncols()) { 
                 query_ncols()=ncols() - currentcol;
             } else {
-                query_ncols()=chunk_ncols();
+                query_ncols()=block_ncols();
             }
             store_ncols()=query_ncols();
 
             // Middle loop across rows.
             while (currentrow < nrows()) {
                 query_rowpos()=currentrow; 
-                const size_t nextrow=currentrow+chunksize;
+                const size_t nextrow=currentrow+block_nrows();
                 if (nextrow > nrows()) { 
                     query_nrows()=nrows() - currentrow;
                 } else {
-                    query_nrows()=chunksize;
+                    query_nrows()=block_nrows();
                 }
                 store_nrows()=query_nrows();
 
-                // Actually reading and writing.
-                store_space.selectHyperslab(H5S_SELECT_SET, store_count, store_offset);
-                mat_space.selectHyperslab(H5S_SELECT_SET, mat_count, mat_offset);
-                ihdata.read(storage.data(), HDT, store_space, mat_space);
-                ohdata.write(storage.data(), HDT, store_space, mat_space);
+                transfer();
                 
                 currentrow=nextrow;
             }
@@ -237,7 +608,8 @@ private:
 template <typename T, bool use_size> 
 SEXP rechunk(Rcpp::StringVector ifile, Rcpp::StringVector idata, 
         Rcpp::StringVector ofile, Rcpp::StringVector odata, 
-        Rcpp::IntegerVector olevel, Rcpp::IntegerVector nelements, Rcpp::LogicalVector byrow) {
+        Rcpp::IntegerVector olevel, Rcpp::IntegerVector nelements, Rcpp::LogicalVector byrow, Rcpp::IntegerVector nthreads,
+        Rcpp::IntegerVector chunkdim, Rcpp::NumericVector memory) {
 
     if (ifile.size()!=1 || idata.size()!=1 || ofile.size()!=1 || odata.size()!=1) {
         throw std::runtime_error("file and dataset names must be strings");
@@ -251,17 +623,83 @@ SEXP rechunk(Rcpp::StringVector ifile, Rcpp::StringVector idata,
     if (byrow.size()!=1) {
         throw std::runtime_error("byrow should be a logical scalar");
     }
+    if (nthreads.size()!=1 || nthreads[0] < 1) {
+        throw std::runtime_error("number of threads should be a positive integer scalar");
+    }
+    size_t onr=0, onc=0;
+    if (chunkdim.size()) {
+        if (chunkdim.size()!=2 || chunkdim[0] < 1 || chunkdim[1] < 1) {
+            throw std::runtime_error("chunk dimensions should be an integer vector of 2 positive values");
+        }
+        onr=chunkdim[0];
+        onc=chunkdim[1];
+    }
+    if (memory.size()!=1 || !(memory[0] >= 1)) {
+        throw std::runtime_error("memory limit should be a positive numeric scalar");
+    }
 
     rechunker<T, use_size> repacker(Rcpp::as<std::string>(ifile[0]), Rcpp::as<std::string>(idata[0]),
             Rcpp::as<std::string>(ofile[0]), Rcpp::as<std::string>(odata[0]), 
-            olevel[0], nelements[0], byrow[0]);
+            olevel[0], nelements[0], byrow[0], nthreads[0], onr, onc, std::min(memory[0], 1e15));
     repacker.execute();
+    beachmat::HDF5_chunk_cache::get_global().invalidate(Rcpp::as<std::string>(ofile[0]));
+    return repacker.get_chunk_dims();
+}
+
+template <typename T, bool use_size> 
+SEXP transpose(Rcpp::StringVector ifile, Rcpp::StringVector idata, 
+        Rcpp::StringVector ofile, Rcpp::StringVector odata, 
+        Rcpp::IntegerVector olevel, Rcpp::IntegerVector chunkdim, Rcpp::IntegerVector nthreads, Rcpp::NumericVector memory) {
+
+    if (ifile.size()!=1 || idata.size()!=1 || ofile.size()!=1 || odata.size()!=1) {
+        throw std::runtime_error("file and dataset names must be strings");
+    }
+    if (olevel.size()!=1) {
+        throw std::runtime_error("compression level should be an integer scalar");
+    }
+    if (chunkdim.size()!=2 || chunkdim[0] < 1 || chunkdim[1] < 1) {
+        throw std::runtime_error("chunk dimensions should be an integer vector of 2 positive values");
+    }
+    if (nthreads.size()!=1 || nthreads[0] < 1) {
+        throw std::runtime_error("number of threads should be a positive integer scalar");
+    }
+    if (memory.size()!=1 || !(memory[0] >= 1)) {
+        throw std::runtime_error("memory limit should be a positive numeric scalar");
+    }
+
+    rechunker<T, use_size> repacker(Rcpp::as<std::string>(ifile[0]), Rcpp::as<std::string>(idata[0]),
+            Rcpp::as<std::string>(ofile[0]), Rcpp::as<std::string>(odata[0]), 
+            olevel[0], 0, true, nthreads[0], chunkdim[0], chunkdim[1], std::min(memory[0], 1e15), true);
+    repacker.execute();
+    beachmat::HDF5_chunk_cache::get_global().invalidate(Rcpp::as<std::string>(ofile[0]));
     return repacker.get_chunk_dims();
 }
 
 /************************** The actual R-visible functions *********************/
 
-SEXP rechunk_matrix(SEXP inname, SEXP indata, SEXP intype, SEXP outname, SEXP outdata, SEXP outlevel, SEXP longdim, SEXP byrow) {
+SEXP rechunk_matrix(SEXP inname, SEXP indata, SEXP intype, SEXP outname, SEXP outdata, SEXP outlevel, SEXP longdim, SEXP byrow, SEXP nthreads, 
+        SEXP chunkdim, SEXP memory) {
+    BEGIN_RCPP
+    // Figuring out the type.
+    Rcpp::StringVector type(intype);
+    if (type.size()!=1) {
+        throw std::runtime_error("type should be a string");
+    }
+    const std::string choice=Rcpp::as<std::string>(type[0]);
+
+    // Dispatching.
+    if (choice=="double") {
+        return rechunk<double, false>(inname, indata, outname, outdata, outlevel, longdim, byrow, nthreads, chunkdim, memory);
+    } else if (choice=="integer" || choice=="logical") { 
+        return rechunk<int, false>(inname, indata, outname, outdata, outlevel, longdim, byrow, nthreads, chunkdim, memory);
+    } else if (choice=="character") {
+        return rechunk<char, true>(inname, indata, outname, outdata, outlevel, longdim, byrow, nthreads, chunkdim, memory);
+    }
+    throw std::runtime_error("unsupported data type");
+    END_RCPP
+}
+
+SEXP transpose_matrix(SEXP inname, SEXP indata, SEXP intype, SEXP outname, SEXP outdata, SEXP outlevel, SEXP chunkdim, SEXP nthreads, SEXP memory) {
     BEGIN_RCPP
     // Figuring out the type.
     Rcpp::StringVector type(intype);
@@ -272,11 +710,11 @@ SEXP rechunk_matrix(SEXP inname, SEXP indata, SEXP intype, SEXP outname, SEXP ou
 
     // Dispatching.
     if (choice=="double") {
-        return rechunk<double, false>(inname, indata, outname, outdata, outlevel, longdim, byrow);
+        return transpose<double, false>(inname, indata, outname, outdata, outlevel, chunkdim, nthreads, memory);
     } else if (choice=="integer" || choice=="logical") { 
-        return rechunk<int, false>(inname, indata, outname, outdata, outlevel, longdim, byrow);
+        return transpose<int, false>(inname, indata, outname, outdata, outlevel, chunkdim, nthreads, memory);
     } else if (choice=="character") {
-        return rechunk<char, true>(inname, indata, outname, outdata, outlevel, longdim, byrow);
+        return transpose<char, true>(inname, indata, outname, outdata, outlevel, chunkdim, nthreads, memory);
     }
     throw std::runtime_error("unsupported data type");
     END_RCPP
@@ -51,7 +51,7 @@ template<typename T, class V>
 template<class Iter>
 void simple_output<T, V>::set_col(size_t c, Iter in, size_t start, size_t end) {
     check_colargs(c, start, end);
-    std::copy(in, in + end - start, data.begin()+c*(this->nrow)+start); 
+    copy_values(in, end - start, data.begin()+c*(this->nrow)+start);
     return;
 }
 
@@ -91,7 +91,7 @@ template<class Iter>
 void simple_output<T, V>::get_col(size_t c, Iter out, size_t start, size_t end) {
     check_colargs(c, start, end);
     auto src=data.begin() + c*(this->nrow);
-    std::copy(src+start, src+end, out);
+    copy_values(src+start, end-start, out);
     return;
 }
 
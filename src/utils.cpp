@@ -1,5 +1,14 @@
 #include "utils.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <cerrno>
+#endif
+
 namespace beachmat {
 
 std::string make_to_string(const Rcpp::RObject& str) {
@@ -15,6 +24,12 @@ void throw_custom_error(const std::string& left, const std::string& classname, c
     throw std::runtime_error(err.str().c_str());
 }
 
+/* Memory limits. */
+
+size_t get_row_index_size_limit() {
+    return 1000000000;
+}
+
 /* Class checks. */
 
 std::string get_class(const Rcpp::RObject& incoming) {
@@ -138,4 +153,203 @@ Rcpp::RObject realize_delayed_array(const Rcpp::RObject& in) {
     return realfun(in);
 }
 
+/* Conversions between double and single precision, four values at a time. */
+
+void copy_values(const double* in, size_t n, float* out) {
+    size_t i=0;
+#ifdef __SSE2__
+    for (; i+4<=n; i+=4) {
+        const __m128 lower=_mm_cvtpd_ps(_mm_loadu_pd(in+i));
+        const __m128 upper=_mm_cvtpd_ps(_mm_loadu_pd(in+i+2));
+        _mm_storeu_ps(out+i, _mm_movelh_ps(lower, upper));
+    }
+#endif
+    for (; i<n; ++i) {
+        out[i]=in[i];
+    }
+    return;
+}
+
+void copy_values(const float* in, size_t n, double* out) {
+    size_t i=0;
+#ifdef __SSE2__
+    for (; i+4<=n; i+=4) {
+        const __m128 current=_mm_loadu_ps(in+i);
+        _mm_storeu_pd(out+i, _mm_cvtps_pd(current));
+        _mm_storeu_pd(out+i+2, _mm_cvtps_pd(_mm_movehl_ps(current, current)));
+    }
+#endif
+    for (; i<n; ++i) {
+        out[i]=in[i];
+    }
+    return;
+}
+
+/* Widening of narrow integers, sixteen (or eight) values at a time. */
+
+void copy_values(const int8_t* in, size_t n, int* out) {
+    size_t i=0;
+#ifdef __SSE2__
+    for (; i+16<=n; i+=16) {
+        const __m128i current=_mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+        const __m128i lower=_mm_unpacklo_epi8(current, current), upper=_mm_unpackhi_epi8(current, current);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_srai_epi32(_mm_unpacklo_epi16(lower, lower), 24));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+4), _mm_srai_epi32(_mm_unpackhi_epi16(lower, lower), 24));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+8), _mm_srai_epi32(_mm_unpacklo_epi16(upper, upper), 24));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+12), _mm_srai_epi32(_mm_unpackhi_epi16(upper, upper), 24));
+    }
+#endif
+    for (; i<n; ++i) {
+        out[i]=in[i];
+    }
+    return;
+}
+
+void copy_values(const uint8_t* in, size_t n, int* out) {
+    size_t i=0;
+#ifdef __SSE2__
+    const __m128i zero=_mm_setzero_si128();
+    for (; i+16<=n; i+=16) {
+        const __m128i current=_mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+        const __m128i lower=_mm_unpacklo_epi8(current, zero), upper=_mm_unpackhi_epi8(current, zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_unpacklo_epi16(lower, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+4), _mm_unpackhi_epi16(lower, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+8), _mm_unpacklo_epi16(upper, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+12), _mm_unpackhi_epi16(upper, zero));
+    }
+#endif
+    for (; i<n; ++i) {
+        out[i]=in[i];
+    }
+    return;
+}
+
+void copy_values(const int16_t* in, size_t n, int* out) {
+    size_t i=0;
+#ifdef __SSE2__
+    for (; i+8<=n; i+=8) {
+        const __m128i current=_mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_srai_epi32(_mm_unpacklo_epi16(current, current), 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+4), _mm_srai_epi32(_mm_unpackhi_epi16(current, current), 16));
+    }
+#endif
+    for (; i<n; ++i) {
+        out[i]=in[i];
+    }
+    return;
+}
+
+void copy_values(const uint16_t* in, size_t n, int* out) {
+    size_t i=0;
+#ifdef __SSE2__
+    const __m128i zero=_mm_setzero_si128();
+    for (; i+8<=n; i+=8) {
+        const __m128i current=_mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_unpacklo_epi16(current, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i+4), _mm_unpackhi_epi16(current, zero));
+    }
+#endif
+    for (; i<n; ++i) {
+        out[i]=in[i];
+    }
+    return;
+}
+
+/* Range of values that can be represented by each narrow integer storage type. 
+ * Returns false if values are not limited, i.e., for the default and floating-point types.
+ */
+
+bool get_storage_limits(storage_type storage, int& lower, int& upper) {
+    switch (storage) {
+        case INT8_STORAGE:
+            lower=-128;
+            upper=127;
+            return true;
+        case UINT8_STORAGE:
+            lower=0;
+            upper=255;
+            return true;
+        case INT16_STORAGE:
+            lower=-32768;
+            upper=32767;
+            return true;
+        case UINT16_STORAGE:
+            lower=0;
+            upper=65535;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Methods for the spill file. */
+
+spill_file::spill_file() : handle(std::tmpfile()), size(0), dirty(false) {
+    if (handle==NULL) {
+        throw std::runtime_error("failed to create a temporary file");
+    }
+}
+
+spill_file::~spill_file() {
+    std::fclose(handle);
+}
+
+void spill_file::seek(size_t offset) {
+#ifdef _WIN32
+    const int status=_fseeki64(handle, offset, SEEK_SET);
+#else
+    const int status=fseeko(handle, offset, SEEK_SET);
+#endif
+    if (status!=0) {
+        throw std::runtime_error("failed to seek in temporary file");
+    }
+    return;
+}
+
+size_t spill_file::append(const char* in, size_t nbytes) {
+    std::lock_guard<std::mutex> lk(lock);
+    const size_t offset=size;
+    seek(offset);
+    if (std::fwrite(in, 1, nbytes, handle)!=nbytes) {
+        throw std::runtime_error("failed to write to temporary file");
+    }
+    size+=nbytes;
+    dirty=true;
+    return offset;
+}
+
+void spill_file::read(size_t offset, char* out, size_t nbytes) {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lk(lock);
+    seek(offset);
+    if (std::fread(out, 1, nbytes, handle)!=nbytes) {
+        throw std::runtime_error("failed to read from temporary file");
+    }
+#else
+    // Flushing buffered appends so that they are visible to pread(), which does not go through the stream.
+    if (dirty) {
+        std::lock_guard<std::mutex> lk(lock);
+        if (std::fflush(handle)!=0) {
+            throw std::runtime_error("failed to write to temporary file");
+        }
+        dirty=false;
+    }
+
+    const int fd=fileno(handle);
+    while (nbytes) {
+        const ssize_t nread=pread(fd, out, nbytes, offset);
+        if (nread < 0 && errno==EINTR) {
+            continue;
+        }
+        if (nread <= 0) {
+            throw std::runtime_error("failed to read from temporary file");
+        }
+        out+=nread;
+        offset+=nread;
+        nbytes-=nread;
+    }
+#endif
+    return;
+}
+
 }
@@ -29,10 +29,113 @@ bool is_pristine_delayed_array(const Rcpp::RObject&);
 
 Rcpp::RObject realize_delayed_array(const Rcpp::RObject&);
 
+// Default memory limit for auxiliary indices.
+
+size_t get_row_index_size_limit();
+
+// Galloping searches, for successive lookups with sorted targets.
+
+template<class Iter, typename X>
+Iter gallop_lower_bound(Iter start, Iter end, const X& target) {
+    size_t step=1;
+    while (start!=end && *start < target) {
+        if (size_t(end-start) <= step) { 
+            return std::lower_bound(start, end, target); 
+        }
+        Iter next=start+step;
+        if (!(*next < target)) { 
+            return std::lower_bound(start, next, target); 
+        }
+        start=next;
+        step*=2;
+    }
+    return start;
+}
+
+template<class Iter, typename X>
+Iter gallop_upper_bound(Iter start, Iter end, const X& target) {
+    size_t step=1;
+    while (start!=end && !(target < *start)) {
+        if (size_t(end-start) <= step) { 
+            return std::upper_bound(start, end, target); 
+        }
+        Iter next=start+step;
+        if (target < *next) { 
+            return std::upper_bound(start, next, target); 
+        }
+        start=next;
+        step*=2;
+    }
+    return start;
+}
+
+/* Copying values between buffers. Conversions between double and single precision, and the
+ * widening of narrow integers, are vectorized where possible, as compilers do not reliably do so at the default optimization level.
+ */
+
+template<class In, class Out>
+void copy_values(In in, size_t n, Out out) {
+    std::copy(in, in+n, out);
+    return;
+}
+
+void copy_values(const double*, size_t, float*);
+
+void copy_values(const float*, size_t, double*);
+
+inline void copy_values(double* in, size_t n, float* out) {
+    copy_values(static_cast<const double*>(in), n, out);
+    return;
+}
+
+inline void copy_values(float* in, size_t n, double* out) {
+    copy_values(static_cast<const float*>(in), n, out);
+    return;
+}
+
+void copy_values(const int8_t*, size_t, int*);
+
+void copy_values(const uint8_t*, size_t, int*);
+
+void copy_values(const int16_t*, size_t, int*);
+
+void copy_values(const uint16_t*, size_t, int*);
+
+/* Temporary binary file for values that do not fit in memory. Values are only ever appended,
+ * so the file can be shared by multiple instances (e.g., clones) that keep track of their
+ * own offsets. Appends are locked, and the file is deleted when it is closed. Reads use 
+ * pread() where available so that multiple threads can read concurrently; otherwise, 
+ * they are also locked as they require a seek.
+ */
+
+class spill_file {
+public:
+    spill_file();
+    ~spill_file();
+    spill_file(const spill_file&) = delete;
+    spill_file& operator=(const spill_file&) = delete;
+
+    size_t append(const char*, size_t);
+    void read(size_t, char*, size_t);
+private:
+    FILE* handle;
+    size_t size;
+    std::mutex lock;
+    std::atomic<bool> dirty; // whether appended values are still buffered by the stream.
+
+    void seek(size_t);
+};
+
 // Matrix type enumeration.
 
 enum matrix_type { SIMPLE, HDF5, SPARSE, RLE, PSYMM, DENSE };
 
+// Storage type enumeration, for values stored in narrower types in HDF5 files.
+
+enum storage_type { DEFAULT_STORAGE, FLOAT_STORAGE, INT8_STORAGE, UINT8_STORAGE, INT16_STORAGE, UINT16_STORAGE };
+
+bool get_storage_limits(storage_type, int&, int&);
+
 }
 
 #endif